@@ -0,0 +1,532 @@
+// Headless benchmark of the GUI library.
+//
+// Builds generated trees of GUI elements on SDL's dummy video driver with a software renderer,
+// and times layout on one and on several threads and in bulk through a LayoutStore, updates, rendering with and without culling,
+// and input dispatch at each requested tree size.
+// Results are written as CSV or JSON so they can be compared between builds.
+//
+// Usage: gui_benchmark [--sizes=1000,10000,100000,1000000] [--depth=4] [--fanout=0]
+//                      [--mix=rect,slider,toggle] [--iterations=0] [--threads=0] [--format=csv|json] [--out=file]
+//                      [--trace=file]
+// A fan-out of 0 is derived from the size and depth, 0 iterations scales with the size,
+// and 0 threads uses every hardware thread for parallel layout.
+// The mix gives relative weights of FilledRect, FloatSlider and Toggle leaves.
+// When built with GUI_PROFILE, the trace option writes the last timings recorded as a Chrome trace.
+
+#include <SDL.hpp>
+#include "../GUI/GUIElements.hpp"
+#include "../GUI/Frame.hpp"
+#include "../GUI/LayoutStore.hpp"
+#include "../GUI/ParallelLayout.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		std::vector<size_t> sizes = { 1000, 10000, 100000, 1000000 };
+		size_t depth = 4;
+		size_t fanout = 0;
+		double mix[3] = { 70., 15., 15. };
+		size_t iterations = 0;
+		unsigned threads = 0;
+		bool json = false;
+		std::string out;
+		std::string trace;
+	};
+
+	struct Result
+	{
+		size_t widgets;
+		size_t nodes;
+		size_t depth;
+		size_t fanout;
+		const char* phase;
+		size_t iterations;
+		double mean_ms;
+		double min_ms;
+		double max_ms;
+		// Elements skipped by culling in one iteration, for phases that cull.
+		size_t culled;
+	};
+
+	std::vector<std::string> Split(const char* list)
+	{
+		std::vector<std::string> parts;
+		std::string cur;
+
+		for (const char* c = list; *c; c++)
+		{
+			if (*c == ',')
+			{
+				parts.push_back(cur);
+				cur.clear();
+			}
+			else cur += *c;
+		}
+
+		parts.push_back(cur);
+		return parts;
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& o)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* a = argv[i];
+			const char* v = std::strchr(a, '=');
+			const std::string key = v == nullptr ? std::string(a) : std::string(a, v - a);
+			if (v != nullptr) v++;
+
+			if (key == "--sizes" && v)
+			{
+				o.sizes.clear();
+				for (auto& s : Split(v)) o.sizes.push_back(std::strtoull(s.c_str(), nullptr, 10));
+			}
+			else if (key == "--depth" && v) o.depth = std::max<size_t>(1, std::strtoull(v, nullptr, 10));
+			else if (key == "--fanout" && v) o.fanout = std::strtoull(v, nullptr, 10);
+			else if (key == "--iterations" && v) o.iterations = std::strtoull(v, nullptr, 10);
+			else if (key == "--threads" && v) o.threads = (unsigned)std::strtoul(v, nullptr, 10);
+			else if (key == "--format" && v) o.json = std::strcmp(v, "json") == 0;
+			else if (key == "--out" && v) o.out = v;
+			else if (key == "--trace" && v) o.trace = v;
+			else if (key == "--mix" && v)
+			{
+				auto parts = Split(v);
+				if (parts.size() != 3) return false;
+				for (int j = 0; j < 3; j++) o.mix[j] = std::strtod(parts[j].c_str(), nullptr);
+			}
+			else
+			{
+				std::fprintf(stderr, "Unknown option %s\n", a);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	const GUI::GUIRect full_shape
+	{
+		{ 0.f, 0.f }, { 0.f, 0.f },
+		{ 1.f, 1.f }, { 0.f, 0.f }
+	};
+
+	const GUI::GUIRect handle_shape
+	{
+		{ 0.f, 0.f }, { -4.f, -4.f },
+		{ 0.f, 0.f }, {  8.f,  8.f }
+	};
+
+	// A generated tree of ContainerGroups with a mix of widgets as leaves.
+	struct Tree
+	{
+		GUI::ContainerGroup root { full_shape };
+		size_t widgets = 0;
+		size_t nodes = 1;
+		size_t fanout = 0;
+		std::vector<GUI::IContainer*> leaves;
+
+		Tree(SDL::Renderer& r, const Options& o, size_t size)
+		{
+			fanout = o.fanout != 0 ? o.fanout : std::max<size_t>(2, (size_t)std::ceil(std::pow((double)size, 1.0 / o.depth)));
+
+			std::mt19937 rng(1234);
+			std::discrete_distribution<int> kind({ o.mix[0], o.mix[1], o.mix[2] });
+
+			_Build(r, root, 1, o.depth, size, rng, kind);
+		}
+
+		~Tree()
+		{
+			GUI::IContainer::DeleteTree(&root);
+		}
+
+		// Adds the groups and leaves of the tree to a field with the same shape as the root,
+		// recording the container each handle stands for.
+		void Mirror(GUI::RectField& field, std::vector<const GUI::IContainer*>& mirrored) const
+		{
+			_Mirror(field, mirrored, root, GUI::RectField::npos);
+		}
+
+	private:
+		void _Mirror(GUI::RectField& field, std::vector<const GUI::IContainer*>& mirrored, const GUI::IContainer& group, GUI::RectField::Handle parent) const
+		{
+			for (size_t i = 0, n = group.NumChildren(); i < n; i++)
+			{
+				const GUI::IContainer& c = group.ChildAt(i);
+				const GUI::RectField::Handle h = field.Add(c.shape, SDL::GREY, parent);
+
+				if (mirrored.size() <= h) mirrored.resize(h + 1);
+				mirrored[h] = &c;
+
+				// Widgets lay out their own children, so only groups are followed
+				if (dynamic_cast<const GUI::ContainerGroup*>(&c) != nullptr) _Mirror(field, mirrored, c, h);
+			}
+		}
+
+		// Splits the grid cell of a child within its parent, so siblings do not overlap.
+		GUI::GUIRect _Cell(size_t index, size_t count) const
+		{
+			const size_t cols = std::max<size_t>(1, (size_t)std::ceil(std::sqrt((double)count)));
+			const size_t rows = (count + cols - 1) / cols;
+			const float w = 1.f / cols;
+			const float h = 1.f / rows;
+
+			return GUI::GUIRect
+			(
+				{ w * (index % cols), h * (index / cols) }, { 1.f, 1.f },
+				{ w, h }, { -2.f, -2.f }
+			);
+		}
+
+		void _Build(SDL::Renderer& r, GUI::IContainer& parent, size_t level, size_t depth, size_t budget, std::mt19937& rng, std::discrete_distribution<int>& kind)
+		{
+			const size_t count = std::min(fanout, budget);
+			if (count == 0) return;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				// Spread the remaining budget over the children
+				const size_t share = budget / count + (i < budget % count ? 1 : 0);
+				const GUI::GUIRect cell = _Cell(i, count);
+
+				if (level < depth && share > 1)
+				{
+					auto group = parent.Emplace<GUI::ContainerGroup>(cell);
+					nodes++;
+
+					_Build(r, *group, level + 1, depth, share, rng, kind);
+				}
+				else
+				{
+					for (size_t j = 0; j < share; j++) _AddWidget(r, parent, kind(rng), cell);
+				}
+			}
+		}
+
+		void _AddWidget(SDL::Renderer& r, GUI::IContainer& parent, int type, const GUI::GUIRect& cell)
+		{
+			GUI::IContainer* widget;
+
+			switch (type)
+			{
+			case 1:
+			{
+				auto slider = parent.Emplace<GUI::FloatSlider>
+				(
+					r, cell,
+					GUI::GUIPosition({ 0.f, .5f }, { 4.f, 0.f }),
+					GUI::GUIPosition({ 1.f, .5f }, { -4.f, 0.f }),
+					handle_shape,
+					0.f, 1.f, .5f,
+					SDL::Button::LEFT
+				);
+				slider->Emplace<GUI::FilledRect>(0, r, handle_shape, SDL::GREY);
+				nodes++;
+				widget = slider;
+				break;
+			}
+			case 2:
+			{
+				auto toggle = parent.Emplace<GUI::Toggle>
+				(
+					r, cell,
+					GUI::GUIPosition({ 0.f, .5f }, { 4.f, 0.f }),
+					GUI::GUIPosition({ 1.f, .5f }, { -4.f, 0.f }),
+					full_shape,
+					false, 50,
+					SDL::Button::LEFT
+				);
+				toggle->Emplace<GUI::FilledRect>(0, r, handle_shape, SDL::GREY);
+				nodes++;
+				widget = toggle;
+				break;
+			}
+			default:
+				widget = parent.Emplace<GUI::BorderedFilledRect>(0, r, cell, SDL::VERY_DARK_GREY, SDL::LIGHT_GREY);
+				break;
+			}
+
+			leaves.push_back(widget);
+			widgets++;
+			nodes++;
+		}
+	};
+
+	template <typename F>
+	Result Measure(const char* phase, size_t iterations, F&& f)
+	{
+		Result res = { 0, 0, 0, 0, phase, iterations, 0., 1e300, 0., 0 };
+
+		for (size_t i = 0; i < iterations; i++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f(i);
+			const auto end = std::chrono::steady_clock::now();
+
+			const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+			res.mean_ms += ms;
+			res.min_ms = std::min(res.min_ms, ms);
+			res.max_ms = std::max(res.max_ms, ms);
+		}
+
+		res.mean_ms /= iterations;
+		return res;
+	}
+
+	void PushMouse(Uint32 type, int x, int y)
+	{
+		SDL_Event e;
+		std::memset(&e, 0, sizeof(e));
+		e.type = type;
+
+		if (type == SDL_MOUSEMOTION)
+		{
+			e.motion.x = x;
+			e.motion.y = y;
+		}
+		else
+		{
+			e.button.button = SDL_BUTTON_LEFT;
+			e.button.state = type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+			e.button.x = x;
+			e.button.y = y;
+		}
+
+		SDL_PushEvent(&e);
+	}
+
+	void Run(SDL::Renderer& r, const Options& o, size_t size, std::vector<Result>& results)
+	{
+		const size_t iterations = o.iterations != 0 ? o.iterations : std::clamp<size_t>(1000000 / std::max<size_t>(size, 1), 3, 100);
+		const SDL::FRect screens[2] = { { 0.f, 0.f, 1280.f, 720.f }, { 0.f, 0.f, 1279.f, 719.f } };
+		const size_t first = results.size();
+
+		std::unique_ptr<Tree> tree;
+
+		results.push_back(Measure("build", 1, [&](size_t)
+		{
+			tree = std::make_unique<Tree>(r, o, size);
+		}));
+
+		results.push_back(Measure("layout_full", iterations, [&](size_t i)
+		{
+			tree->root.SetParentShape(screens[i % 2]);
+		}));
+
+		GUI::ParallelLayout pool(o.threads != 0 ? o.threads : std::thread::hardware_concurrency());
+
+		results.push_back(Measure("layout_full_parallel", iterations, [&](size_t i)
+		{
+			pool.Run(tree->root, screens[i % 2]);
+		}));
+
+		tree->root.SetParentShape(screens[0]);
+
+		{
+			// The same hierarchy as plain rects, laid out a level at a time by a LayoutStore
+			GUI::RectField field(0, r, tree->root.shape);
+			std::vector<const GUI::IContainer*> mirrored;
+			tree->Mirror(field, mirrored);
+
+			results.push_back(Measure("layout_store", iterations, [&](size_t i)
+			{
+				field.SetParentShape(screens[i % 2]);
+			}));
+
+			field.SetParentShape(screens[0]);
+
+			size_t differ = 0;
+			field.Store().ForEach([&](GUI::RectField::Handle h, const SDL::FRect& rect)
+			{
+				const GUI::IContainer& c = *mirrored[h];
+				if (!(rect == c.shape.Get(c.parent_shape))) differ++;
+			});
+
+			if (differ != 0) std::fprintf(stderr, "layout_store: %zu of %zu rects differ from layout_full\n", differ, field.Store().Size());
+		}
+
+		std::mt19937 rng(99);
+
+		results.push_back(Measure("layout_one_leaf", iterations, [&](size_t)
+		{
+			tree->leaves[rng() % tree->leaves.size()]->InvalidateLayout();
+			tree->root.SetParentShape(screens[0]);
+		}));
+
+		results.push_back(Measure("update_all", iterations, [&](size_t)
+		{
+			GUI::IUpdateable::UpdateAll(16);
+		}));
+
+		results.push_back(Measure("render_all", iterations, [&](size_t)
+		{
+			r.SetDrawColour(SDL::BLACK);
+			r.Clear();
+			GUI::IRenderable::RenderAllGUI();
+		}));
+
+		// The tree laid out over a canvas 4 screens wide and tall, scrolled to its middle,
+		// so culling skips most of it.
+		const SDL::FRect canvas = { -1920.f, -1080.f, 5120.f, 2880.f };
+		tree->root.SetParentShape(canvas);
+
+		results.push_back(Measure("render_culled", iterations, [&](size_t)
+		{
+			r.SetDrawColour(SDL::BLACK);
+			r.Clear();
+			GUI::IContainer::Cull(tree->root, screens[0]);
+			GUI::IRenderable::RenderAllGUI();
+		}));
+
+		results.back().culled = GUI::IRenderable::NumCulled();
+
+		GUI::IContainer::StopCulling();
+		tree->root.SetParentShape(screens[0]);
+
+		GUI::RetainedFrame frame(r);
+		frame.Render();
+
+		results.push_back(Measure("render_retained_idle", iterations, [&](size_t)
+		{
+			frame.Render();
+		}));
+
+		results.push_back(Measure("render_retained_one_leaf", iterations, [&](size_t)
+		{
+			GUI::IContainer* leaf = tree->leaves[rng() % tree->leaves.size()];
+			if (auto renderable = dynamic_cast<GUI::IRenderable*>(leaf)) renderable->Invalidate();
+			frame.Render();
+		}));
+
+		// Press, drag across the window and release, then dispatch the queued events.
+		const int events = 64;
+
+		results.push_back(Measure("input_dispatch", iterations, [&](size_t)
+		{
+			PushMouse(SDL_MOUSEBUTTONDOWN, 640, 360);
+			for (int e = 0; e < events - 2; e++) PushMouse(SDL_MOUSEMOTION, (e * 37) % 1280, (e * 23) % 720);
+			PushMouse(SDL_MOUSEBUTTONUP, 640, 360);
+
+			SDL::Input::Update();
+			GUI::PointerRouter::Flush();
+		}));
+
+		// Counts are only known once the tree is built, so they are filled in before it is torn down
+		const size_t widgets = tree->widgets;
+		const size_t nodes = tree->nodes;
+		const size_t fanout = tree->fanout;
+
+		results.push_back(Measure("teardown", 1, [&](size_t)
+		{
+			tree.reset();
+		}));
+
+		for (size_t i = first; i < results.size(); i++)
+		{
+			results[i].widgets = widgets;
+			results[i].nodes = nodes;
+			results[i].depth = o.depth;
+			results[i].fanout = fanout;
+		}
+	}
+
+	void Write(FILE* f, const Options& o, const std::vector<Result>& results)
+	{
+		if (o.json)
+		{
+			std::fprintf(f, "[\n");
+
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const Result& r = results[i];
+				std::fprintf(f, "  { \"widgets\": %zu, \"nodes\": %zu, \"depth\": %zu, \"fanout\": %zu, \"phase\": \"%s\", \"iterations\": %zu, \"mean_ms\": %.6f, \"min_ms\": %.6f, \"max_ms\": %.6f, \"culled\": %zu }%s\n",
+					r.widgets, r.nodes, r.depth, r.fanout, r.phase, r.iterations, r.mean_ms, r.min_ms, r.max_ms, r.culled, i + 1 < results.size() ? "," : "");
+			}
+
+			std::fprintf(f, "]\n");
+		}
+		else
+		{
+			std::fprintf(f, "widgets,nodes,depth,fanout,phase,iterations,mean_ms,min_ms,max_ms,culled\n");
+
+			for (const Result& r : results)
+			{
+				std::fprintf(f, "%zu,%zu,%zu,%zu,%s,%zu,%.6f,%.6f,%.6f,%zu\n",
+					r.widgets, r.nodes, r.depth, r.fanout, r.phase, r.iterations, r.mean_ms, r.min_ms, r.max_ms, r.culled);
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	using namespace SDL;
+
+	Options o;
+
+	if (!ParseOptions(argc, argv, o)) return 1;
+
+	// Must be set before the video subsystem starts
+	SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+	if (!Init(InitFlags::VIDEO | InitFlags::EVENTS))
+	{
+		return 1;
+	}
+
+	if (!Input::Init())
+	{
+		Quit();
+		return 1;
+	}
+
+	GUI::PointerRouter::Init();
+
+	std::vector<Result> results;
+
+	{
+		Window w;
+		Renderer r;
+
+		if (CreateWindowAndRenderer({ 1280, 720 }, w, r, WindowFlags::HIDDEN))
+		{
+			for (size_t size : o.sizes)
+			{
+				if (size != 0) Run(r, o, size, results);
+			}
+		}
+	}
+
+	GUI::PointerRouter::Quit();
+	Input::Quit();
+	Quit();
+
+	FILE* f = o.out.empty() ? stdout : std::fopen(o.out.c_str(), "w");
+	if (f == nullptr) return 1;
+
+	Write(f, o, results);
+
+	if (f != stdout) std::fclose(f);
+
+	if (!o.trace.empty())
+	{
+#ifdef GUI_PROFILE
+		if (!GUI::Profiler::WriteTrace(o.trace.c_str())) return 1;
+#else
+		std::fprintf(stderr, "Built without GUI_PROFILE, no trace was recorded\n");
+#endif
+	}
+
+	return 0;
+}
\ No newline at end of file
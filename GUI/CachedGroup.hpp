@@ -0,0 +1,252 @@
+#pragma once
+#include "GUI.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace GUI
+{
+	// A group of children drawn once into a texture, which is then copied to the screen in their place.
+	// The texture is redrawn only when an element in the group is invalidated, or the group is laid out
+	// again, so a mostly static panel costs one copy per frame instead of a draw per element.
+	// Children draw clipped to the group. Call RebuildAll before rendering, as RetainedFrame does.
+	struct CachedGroup : public IRenderable
+	{
+		SDL::Renderer& r;
+
+		inline CachedGroup(SDL::Renderer& r, const GUIRect& shape, int render_order = 0, bool render_enabled = true)
+			: IRenderable(shape, render_order, render_enabled), r(r)
+		{
+			_MarkDirty();
+		}
+
+		inline ~CachedGroup()
+		{
+			_Untag();
+
+			auto it = std::find(_dirty.begin(), _dirty.end(), this);
+			if (it != _dirty.end()) _dirty.erase(it);
+
+			ClearChildren();
+		}
+
+		size_t NumChildren() const { return _children.size(); }
+		size_t ChildPosition(std::shared_ptr<IContainer> child) const
+		{
+			const size_t slot = _GetSlot(*child);
+			return slot < _children.size() && _children[slot] == child ? slot : ~(size_t)0;
+		}
+
+		// Whether the texture will be redrawn before it is next copied.
+		inline bool IsCacheDirty() const { return _cache_dirty; }
+
+		// Redraws the texture of every group that changed. Call outside of any render target.
+		inline static void RebuildAll()
+		{
+			GUI_PROFILE_SCOPE("CachedGroup::RebuildAll", "dirty", (int64_t)_dirty.size());
+
+			while (!_dirty.empty())
+			{
+				CachedGroup* g = _dirty.back();
+				_dirty.pop_back();
+
+				g->_Rebuild();
+			}
+		}
+
+		void RenderGUI()
+		{
+			if (!_texture) return;
+
+			const SDL::Point size = _texture.GetSize();
+			r.CopyF(_texture, SDL::Rect(0, 0, size.w, size.h), SDL::FRect(std::floor(_shape.x), std::floor(_shape.y), (float)size.w, (float)size.h));
+		}
+
+	protected:
+		std::vector<std::shared_ptr<IContainer>> _children = {};
+
+		// Elements drawing into the texture, in render order.
+		std::vector<IRenderable*> _members = {};
+		// Groups within this one, whose textures are drawn into this one.
+		std::vector<CachedGroup*> _nested = {};
+
+		SDL::FRect _shape = {};
+		SDL::Texture _texture;
+		bool _cache_dirty = false;
+
+		inline static std::vector<CachedGroup*> _dirty = {};
+
+		bool _AddChild(std::shared_ptr<IContainer> child)
+		{
+			_SetSlot(*child, _children.size());
+			_children.push_back(child);
+			return true;
+		}
+
+		bool _InsertChild(size_t index, std::shared_ptr<IContainer> child)
+		{
+			_children.insert(std::next(_children.begin(), index), child);
+			for (size_t i = index; i < _children.size(); i++) _SetSlot(*_children[i], i);
+			return true;
+		}
+
+		// Children keep their order, which decides the draw order of elements sharing a render order.
+		void _RemoveChild(size_t index)
+		{
+			assert(index < _children.size());
+
+			_SetSlot(*_children[index], ~(size_t)0);
+			_children.erase(std::next(_children.begin(), index));
+			for (size_t i = index; i < _children.size(); i++) _SetSlot(*_children[i], i);
+		}
+
+		void _ClearChildren()
+		{
+			for (auto& c : _children)
+			{
+				c->parent = nullptr;
+				_SetSlot(*c, ~(size_t)0);
+			}
+
+			_children.clear();
+		}
+		std::shared_ptr<IContainer> _GetChild(size_t index) const
+		{
+			assert(index < _children.size());
+			return _children[index];
+		}
+		IContainer* _ChildAt(size_t index) const
+		{
+			assert(index < _children.size());
+			return _children[index].get();
+		}
+
+		void _SetParentShape(const SDL::FRect& parent)
+		{
+			_shape = shape.Get(parent);
+			SetBounds(_shape);
+
+			for (auto& c : _children)
+			{
+				c->SetParentShape(_shape);
+			}
+		}
+
+		// Subtrees laid out on other threads damage through the old tags until they are joined.
+		void _OnSubtreeLaidOut()
+		{
+			_Retag();
+		}
+
+		void _OnCachedInvalidate()
+		{
+			_MarkDirty();
+		}
+
+		void _OnCachedDestroyed(IRenderable& member)
+		{
+			auto it = std::find(_members.begin(), _members.end(), &member);
+			if (it != _members.end()) _members.erase(it);
+
+			auto nested = std::find(_nested.begin(), _nested.end(), &member);
+			if (nested != _nested.end()) _nested.erase(nested);
+
+			_MarkDirty();
+		}
+
+		inline void _MarkDirty()
+		{
+			LayoutLock lock;
+
+			if (!_cache_dirty)
+			{
+				_cache_dirty = true;
+				_dirty.push_back(this);
+			}
+
+			Invalidate();
+		}
+
+		inline void _Untag()
+		{
+			for (IRenderable* m : _members)
+			{
+				if (_GetCacheOwner(*m) == this) _SetCacheOwner(*m, nullptr);
+			}
+
+			_members.clear();
+			_nested.clear();
+		}
+
+		// Finds the elements drawing into this group again, after its subtree was laid out.
+		inline void _Retag()
+		{
+			_Untag();
+
+			for (auto& c : _children) _Collect(*c);
+
+			std::stable_sort(_members.begin(), _members.end(), [](IRenderable* a, IRenderable* b) { return a->GetOrder() < b->GetOrder(); });
+
+			_MarkDirty();
+		}
+
+		inline void _Collect(IContainer& c)
+		{
+			if (IRenderable* rend = dynamic_cast<IRenderable*>(&c))
+			{
+				_SetCacheOwner(*rend, this);
+				_members.push_back(rend);
+
+				// Nested groups draw their own children
+				if (CachedGroup* group = dynamic_cast<CachedGroup*>(rend))
+				{
+					_nested.push_back(group);
+					return;
+				}
+			}
+
+			for (size_t i = 0, n = c.NumChildren(); i < n; i++)
+			{
+				_Collect(c.ChildAt(i));
+			}
+		}
+
+		inline void _Rebuild()
+		{
+			if (!_cache_dirty) return;
+			_cache_dirty = false;
+
+			// Nested groups are drawn into this one, so they must be up to date first
+			for (CachedGroup* g : _nested) g->_Rebuild();
+
+			// Whole pixels covering the group
+			const int x = (int)std::floor(_shape.x);
+			const int y = (int)std::floor(_shape.y);
+			const SDL::Point size = { (int)std::ceil(_shape.x + _shape.w) - x, (int)std::ceil(_shape.y + _shape.h) - y };
+
+			if (size.w <= 0 || size.h <= 0)
+			{
+				_texture = SDL::Texture();
+				return;
+			}
+
+			if (!_texture || !(_texture.GetSize() == size))
+			{
+				_texture = SDL::Texture(r, SDL::PixelFormatEnum::RGBA8888, SDL::TextureAccess::TARGET, size);
+				_texture.SetBlendMode(SDL::BlendMode::BLEND);
+			}
+
+			r.SetTarget(_texture);
+			r.SetDrawColour(SDL::Colour(0, 0, 0, 0));
+			r.Clear();
+
+			// Elements draw in screen coordinates, so the viewport moves the top left of the group to the origin
+			r.SetViewport(SDL::Rect(-x, -y, x + size.w, y + size.h));
+
+			_RenderEach(_members);
+
+			r.SetViewport();
+			r.SetTarget();
+		}
+	};
+}
\ No newline at end of file
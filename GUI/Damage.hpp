@@ -0,0 +1,187 @@
+#pragma once
+#include <SDL.hpp>
+#include "Sync.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+namespace GUI
+{
+	// Screen areas that changed since the last frame, merged into a small set of regions.
+	// GUI elements report their old and new screen bounds here when they change, and
+	// RetainedFrame redraws only these regions.
+	struct Damage
+	{
+		// Regions are merged until there are at most this many.
+		static constexpr size_t max_regions = 8;
+
+		inline static void Add(const SDL::FRect& area)
+		{
+			// Threads of a parallel layout queue their areas for AddDeferred rather than contend for a lock
+			if (LayoutLock::active)
+			{
+				_deferred.areas.push_back(area);
+				return;
+			}
+
+			if (_full || !(area.w > 0.f) || !(area.h > 0.f)) return;
+
+			// Round outwards, with a pixel of margin for outlines drawn on the edge.
+			const int x0 = (int)std::floor(area.x) - 1;
+			const int y0 = (int)std::floor(area.y) - 1;
+			const int x1 = (int)std::ceil(area.x + area.w) + 1;
+			const int y1 = (int)std::ceil(area.y + area.h) + 1;
+
+			_Merge(SDL::Rect(x0, y0, x1 - x0, y1 - y0));
+		}
+
+		// Marks the whole screen as damaged.
+		inline static void AddAll()
+		{
+			LayoutLock lock;
+
+			_full = true;
+			_regions.clear();
+		}
+
+		// Adds the areas queued by every thread during a parallel layout. Called by ParallelLayout after a pass.
+		inline static void AddDeferred()
+		{
+			std::lock_guard<std::mutex> lock(_threads_mutex);
+
+			for (Deferred* d : _threads)
+			{
+				for (const SDL::FRect& area : d->areas) Add(area);
+				d->areas.clear();
+			}
+		}
+
+		inline static bool Any() { return _full || !_regions.empty(); }
+		inline static bool All() { return _full; }
+
+		// The damaged regions clipped to a screen of the given size.
+		inline static const std::vector<SDL::Rect>& Regions(const SDL::Point& screen)
+		{
+			_clipped.clear();
+
+			if (_full)
+			{
+				_clipped.push_back(SDL::Rect(0, 0, screen.w, screen.h));
+				return _clipped;
+			}
+
+			for (const SDL::Rect& r : _regions)
+			{
+				const int x0 = std::max(r.x, 0);
+				const int y0 = std::max(r.y, 0);
+				const int x1 = std::min(r.x + r.w, screen.w);
+				const int y1 = std::min(r.y + r.h, screen.h);
+
+				if (x1 > x0 && y1 > y0) _clipped.push_back(SDL::Rect(x0, y0, x1 - x0, y1 - y0));
+			}
+
+			return _clipped;
+		}
+
+		inline static void Clear()
+		{
+			_full = false;
+			_regions.clear();
+		}
+
+		inline static bool Intersects(const SDL::FRect& a, const SDL::Rect& b)
+		{
+			return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+		}
+
+	private:
+		inline static std::vector<SDL::Rect> _regions = {};
+		inline static std::vector<SDL::Rect> _clipped = {};
+		inline static bool _full = false;
+
+		// The areas one thread added during a parallel layout, listed in _threads for its lifetime.
+		struct Deferred
+		{
+			std::vector<SDL::FRect> areas = {};
+
+			inline Deferred()
+			{
+				std::lock_guard<std::mutex> lock(_threads_mutex);
+				_threads.push_back(this);
+			}
+
+			inline ~Deferred()
+			{
+				std::lock_guard<std::mutex> lock(_threads_mutex);
+				_threads.erase(std::find(_threads.begin(), _threads.end(), this));
+			}
+		};
+
+		inline static std::vector<Deferred*> _threads = {};
+		inline static std::mutex _threads_mutex;
+		inline static thread_local Deferred _deferred;
+
+		inline static SDL::Rect _Union(const SDL::Rect& a, const SDL::Rect& b)
+		{
+			const int x0 = std::min(a.x, b.x);
+			const int y0 = std::min(a.y, b.y);
+			const int x1 = std::max(a.x + a.w, b.x + b.w);
+			const int y1 = std::max(a.y + a.h, b.y + b.h);
+
+			return SDL::Rect(x0, y0, x1 - x0, y1 - y0);
+		}
+
+		inline static int64_t _Area(const SDL::Rect& r) { return (int64_t)r.w * r.h; }
+
+		inline static bool _Touches(const SDL::Rect& a, const SDL::Rect& b)
+		{
+			return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+		}
+
+		// Absorbs every region the new one touches, then merges the cheapest pairs
+		// until there are no more than max_regions.
+		inline static void _Merge(SDL::Rect r)
+		{
+			for (size_t i = 0; i < _regions.size();)
+			{
+				if (_Touches(_regions[i], r))
+				{
+					r = _Union(_regions[i], r);
+					_regions[i] = _regions.back();
+					_regions.pop_back();
+					i = 0;
+				}
+				else i++;
+			}
+
+			_regions.push_back(r);
+
+			while (_regions.size() > max_regions)
+			{
+				size_t best_a = 0, best_b = 1;
+				int64_t best_cost = INT64_MAX;
+
+				for (size_t a = 0; a < _regions.size(); a++)
+				{
+					for (size_t b = a + 1; b < _regions.size(); b++)
+					{
+						const int64_t cost = _Area(_Union(_regions[a], _regions[b])) - _Area(_regions[a]) - _Area(_regions[b]);
+
+						if (cost < best_cost)
+						{
+							best_cost = cost;
+							best_a = a;
+							best_b = b;
+						}
+					}
+				}
+
+				_regions[best_a] = _Union(_regions[best_a], _regions[best_b]);
+				_regions[best_b] = _regions.back();
+				_regions.pop_back();
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#pragma once
+#include "GUI.hpp"
+#include <vector>
+#include <algorithm>
+
+namespace GUI
+{
+	// Outlines the layout of a tree over the rendered GUI, and can be switched on at any time:
+	// - the shape of each container, in azure
+	// - the parent shape each container was laid out in, in red, once per distinct area
+	// - the anchored area of each shape before offsets, in orange, with white marks outside its corners
+	// Outlines of each colour are collected as 1 pixel rects and drawn with a single FillRectsF call,
+	// and rects wholly outside the view are left out, so even large trees stay interactive.
+	struct DebugDraw
+	{
+		enum Layer : unsigned
+		{
+			NONE = 0,
+			ANCHORS = 1,
+			SHAPES = 2,
+			PARENTS = 4,
+			ALL = ANCHORS | SHAPES | PARENTS
+		};
+
+		// Layers drawn by Render. Defining DEBUG_GUI_CONTAINERS starts with every layer on.
+#ifdef DEBUG_GUI_CONTAINERS
+		inline static unsigned layers = ALL;
+#else
+		inline static unsigned layers = NONE;
+#endif
+
+		// Draws the enabled layers for a laid out tree, over whatever is on the renderer.
+		inline static void Render(SDL::Renderer& r, IContainer& root, const SDL::FRect& view)
+		{
+			if (layers == NONE) return;
+
+			_Begin(view);
+
+			if (layers & PARENTS) _Add(_parents, root.parent_shape);
+
+			root.VisitDepthFirst([](IContainer& c) { _Collect(c); });
+
+			_Draw(r);
+		}
+
+#ifdef DEBUG_GUI_CONTAINERS
+		// Draws the enabled layers for every container that exists, including those in no tree.
+		inline static void RenderAll(SDL::Renderer& r, const SDL::FRect& view)
+		{
+			if (layers == NONE) return;
+
+			_Begin(view);
+
+			for (IContainer* c : IContainer::AllContainers())
+			{
+				if ((layers & PARENTS) && c->parent == nullptr) _Add(_parents, c->parent_shape);
+				_Collect(*c);
+			}
+
+			_Draw(r);
+		}
+#endif
+
+	private:
+		// Kept between frames, so collecting outlines does not allocate once they have grown.
+		inline static std::vector<SDL::FRect> _parents = {};
+		inline static std::vector<SDL::FRect> _shapes = {};
+		inline static std::vector<SDL::FRect> _anchors = {};
+		inline static std::vector<SDL::FRect> _marks = {};
+		inline static SDL::FRect _view = {};
+
+		inline static void _Begin(const SDL::FRect& view)
+		{
+			_view = view;
+			_parents.clear();
+			_shapes.clear();
+			_anchors.clear();
+			_marks.clear();
+		}
+
+		inline static void _Draw(SDL::Renderer& r)
+		{
+			// Anything queued belongs under the outlines
+			RectBatch::Flush();
+
+			_Fill(r, SDL::RED, _parents);
+			_Fill(r, SDL::AZURE, _shapes);
+			_Fill(r, SDL::ORANGE, _anchors);
+			_Fill(r, SDL::WHITE, _marks);
+		}
+
+		inline static void _Fill(SDL::Renderer& r, const SDL::Colour& colour, const std::vector<SDL::FRect>& rects)
+		{
+			if (rects.empty()) return;
+
+			r.SetDrawColour(colour);
+			r.FillRectsF(rects);
+		}
+
+		// Adds the outlines of one container. Parent shapes are added by the parent, once for each run
+		// of children sharing one, as siblings are usually laid out in the same area.
+		inline static void _Collect(const IContainer& c)
+		{
+			if (layers & SHAPES) _Add(_shapes, c.shape.Get(c.parent_shape));
+
+			if (layers & ANCHORS)
+			{
+				const SDL::FRect& p = c.parent_shape;
+				const SDL::FRect a(p.pos + p.size * c.shape.position.anchor, p.size * c.shape.size.anchor);
+
+				_Add(_anchors, a);
+
+				_Mark(a.x - 5.f, a.y - 5.f);
+				_Mark(a.x + a.w + 2.f, a.y - 5.f);
+				_Mark(a.x + a.w + 2.f, a.y + a.h + 2.f);
+				_Mark(a.x - 5.f, a.y + a.h + 2.f);
+			}
+
+			if (layers & PARENTS)
+			{
+				const SDL::FRect* last = nullptr;
+
+				for (size_t i = 0, n = c.NumChildren(); i < n; i++)
+				{
+					const SDL::FRect& area = c.ChildAt(i).parent_shape;
+					if (last != nullptr && area == *last) continue;
+
+					_Add(_parents, area);
+					last = &area;
+				}
+			}
+		}
+
+		inline static void _Mark(float x, float y)
+		{
+			_Push(_marks, SDL::FRect(x, y, 3.f, 3.f));
+		}
+
+		// Adds the 1 pixel outline of a rect. Rects without width or height are drawn as a line or point.
+		inline static void _Add(std::vector<SDL::FRect>& out, SDL::FRect rect)
+		{
+			if (rect.w < 0.f) { rect.x += rect.w; rect.w = -rect.w; }
+			if (rect.h < 0.f) { rect.y += rect.h; rect.h = -rect.h; }
+
+			if (rect.w <= 2.f || rect.h <= 2.f)
+			{
+				_Push(out, SDL::FRect(rect.x, rect.y, std::max(rect.w, 1.f), std::max(rect.h, 1.f)));
+				return;
+			}
+
+			_Push(out, SDL::FRect(rect.x, rect.y, rect.w, 1.f));
+			_Push(out, SDL::FRect(rect.x, rect.y + rect.h - 1.f, rect.w, 1.f));
+			_Push(out, SDL::FRect(rect.x, rect.y + 1.f, 1.f, rect.h - 2.f));
+			_Push(out, SDL::FRect(rect.x + rect.w - 1.f, rect.y + 1.f, 1.f, rect.h - 2.f));
+		}
+
+		inline static void _Push(std::vector<SDL::FRect>& out, const SDL::FRect& rect)
+		{
+			if (_Intersects(rect)) out.push_back(rect);
+		}
+
+		inline static bool _Intersects(const SDL::FRect& rect)
+		{
+			return rect.x < _view.x + _view.w && _view.x < rect.x + rect.w
+			    && rect.y < _view.y + _view.h && _view.y < rect.y + rect.h;
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include "GUI.hpp"
+#include "CachedGroup.hpp"
+
+namespace GUI
+{
+	// Keeps the rendered GUI in a persistent render target, and each frame redraws only the
+	// regions reported to Damage, after redrawing any CachedGroup that changed. Each region is cleared and redrawn with its own clip rect,
+	// and only elements whose bounds intersect it are rendered.
+	struct RetainedFrame
+	{
+		SDL::Colour clear_colour = SDL::BLACK;
+
+		// Copies the target to the screen every frame, even if nothing was redrawn, so that something
+		// drawn over it each frame, such as the Stats overlay, stays up to date.
+		bool always_present = false;
+
+		inline RetainedFrame(SDL::Renderer& r) : r(r) {}
+
+		// Brings the render target up to date and copies it to the screen if any part of it was redrawn.
+		// Returns true if it was, or always_present is set, in which case the frame should be presented.
+		bool Render()
+		{
+			GUI_PROFILE_SCOPE("RetainedFrame::Render");
+
+			CachedGroup::RebuildAll();
+
+			const SDL::Point size = r.GetOutputSize();
+
+			if (!(size == _size))
+			{
+				_target = SDL::Texture(r, SDL::PixelFormatEnum::RGBA8888, SDL::TextureAccess::TARGET, size);
+				_size = size;
+				Damage::AddAll();
+			}
+
+			const bool redraw = Damage::Any();
+
+			if (redraw)
+			{
+				r.SetTarget(_target);
+
+				for (const SDL::Rect& region : Damage::Regions(_size))
+				{
+					r.SetClipRect(region);
+					r.SetDrawColour(clear_colour);
+					r.FillRectF(SDL::FRect((float)region.x, (float)region.y, (float)region.w, (float)region.h));
+
+					IRenderable::RenderAllGUI(region);
+				}
+
+				r.DisableClip();
+				r.SetTarget();
+
+				Damage::Clear();
+			}
+
+			if (redraw || always_present) r.Copy(_target);
+
+			return redraw || always_present;
+		}
+
+	private:
+		SDL::Renderer& r;
+		SDL::Texture _target;
+		SDL::Point _size = { 0, 0 };
+	};
+
+	// Paces the main loop, sleeping until there is input when nothing needs to be laid out,
+	// redrawn or updated. Awake IUpdateables keep the loop running.
+	struct FrameScheduler
+	{
+		// Longest time to sleep while idle, in milliseconds.
+		inline static int max_idle_wait = 1000;
+
+		// Keeps the loop running for another frame.
+		inline static void RequestFrame() { _requested = true; }
+
+		inline static bool Idle(const IContainer& root)
+		{
+			return !_requested && IUpdateable::NumActive() == 0 && !Damage::Any() && !root.IsLayoutDirty();
+		}
+
+		// A frame presented every frame is never idle, so whatever is drawn over it stays current.
+		inline static bool Idle(const IContainer& root, const RetainedFrame& frame)
+		{
+			return !frame.always_present && Idle(root);
+		}
+
+		// Waits for input if idle, then returns the time since the last frame.
+		// Time spent idle is not counted, so animations started by input do not skip ahead.
+		inline static Uint64 NextFrame(const IContainer& root)
+		{
+			return _Next(Idle(root));
+		}
+
+		inline static Uint64 NextFrame(const IContainer& root, const RetainedFrame& frame)
+		{
+			return _Next(Idle(root, frame));
+		}
+
+	private:
+		inline static bool _requested = true;
+		inline static Uint64 _last = 0;
+
+		inline static Uint64 _Next(bool idle)
+		{
+			if (idle)
+			{
+				SDL_WaitEventTimeout(nullptr, max_idle_wait);
+				_last = SDL::GetTicks64();
+			}
+
+			_requested = false;
+
+			const Uint64 t = SDL::GetTicks64();
+			const Uint64 dT = _last == 0 ? 0 : t - _last;
+			_last = t;
+
+			return dT;
+		}
+	};
+}
\ No newline at end of file
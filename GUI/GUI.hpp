@@ -1,6 +1,15 @@
+#pragma once
 #include <SDL.hpp>
+#include "RectBatch.hpp"
+#include "Registry.hpp"
+#include "Damage.hpp"
+#include "Pool.hpp"
+#include "Profiler.hpp"
+#include "Stats.hpp"
 #include <algorithm>
-#include <map>
+#include <atomic>
+#include <type_traits>
+#include <vector>
 #include <assert.h>
 
 namespace GUI
@@ -23,6 +32,16 @@ namespace GUI
 			return parent.pos + parent.size * anchor + offset;
 		}
 
+		inline constexpr bool operator==(const GUIPosition& other) const
+		{
+			return anchor == other.anchor && offset == other.offset;
+		}
+
+		inline constexpr bool operator!=(const GUIPosition& other) const
+		{
+			return !(*this == other);
+		}
+
 		inline constexpr GUIPosition operator+(const GUIPosition& other) const
 		{
 			return GUIPosition(anchor + other.anchor, offset + other.offset);
@@ -85,11 +104,21 @@ namespace GUI
 			: anchor(anchor), offset(offset) {}
 
 		// Evaluates this GUISize relative to a parent into an FPoint.
-		inline const SDL::FPoint Get(const SDL::FRect& parent) const
+		inline constexpr SDL::FPoint Get(const SDL::FRect& parent) const
 		{
 			return parent.size * anchor + offset;
 		}
 
+		inline constexpr bool operator==(const GUISize& other) const
+		{
+			return anchor == other.anchor && offset == other.offset;
+		}
+
+		inline constexpr bool operator!=(const GUISize& other) const
+		{
+			return !(*this == other);
+		}
+
 		inline constexpr GUISize operator+(const GUISize& other) const
 		{
 			return GUISize(anchor + other.anchor, offset + other.offset);
@@ -168,6 +197,16 @@ namespace GUI
 			};
 		}
 
+		inline constexpr bool operator==(const GUIRect& other) const
+		{
+			return position == other.position && size == other.size;
+		}
+
+		inline constexpr bool operator!=(const GUIRect& other) const
+		{
+			return !(*this == other);
+		}
+
 		inline constexpr GUIRect operator+(const GUIPosition& other) const
 		{
 			return GUIRect(position + other, size);
@@ -213,15 +252,112 @@ namespace GUI
 		}
 	};
 
+	// A mouse event as delivered to GUI components by PointerRouter.
+	struct PointerEvent
+	{
+		enum class Type { DOWN, UP, MOTION, WHEEL };
+
+		Type type;
+		// Pointer position in screen coordinates.
+		SDL::Point position;
+		// The button pressed or released, 0 for motion and the wheel.
+		Uint8 button;
+		// The event as received from SDL::Input. For merged motion, the last event merged, with the
+		// relative motion of all of them.
+		const SDL::Event& event;
+		// For merged motion, the position of every event merged into this one, oldest first, while
+		// PointerRouter keeps history. Otherwise nullptr.
+		const std::vector<SDL::Point>* history = nullptr;
+	};
+
+	struct IContainer;
+
+	// Takes over the layout of subtrees from SetParentShape, such as to run them on other threads.
+	// Installed by ParallelLayout for the duration of a pass.
+	struct LayoutScheduler
+	{
+		// The subtrees handed off while one container lays itself out, which it waits for before finishing.
+		struct Join
+		{
+			std::atomic<size_t> pending = 0;
+			Join* outer = nullptr;
+		};
+
+		// Returns true if the scheduler will lay out the container itself, later in the pass.
+		virtual bool Defer(IContainer& c, const SDL::FRect& parent) = 0;
+
+		// Collects the subtrees handed off until End into join.
+		virtual void Begin(Join& join) = 0;
+		// Waits for every subtree in join, running them or other tasks meanwhile.
+		virtual void End(Join& join) = 0;
+
+	protected:
+		// Lays out a container that Defer accepted, without offering it to Defer again.
+		inline static void _LayoutNow(IContainer& c, const SDL::FRect& parent);
+		// Grows the subtree bounds of the ancestors of c to cover it, which is skipped during a pass.
+		inline static void _GrowAncestors(IContainer& c);
+		// Makes SetParentShape offer subtrees to a scheduler, or stop with nullptr.
+		inline static void _SetScheduler(LayoutScheduler* scheduler);
+	};
+
 	// A base type for GUI components with awareness of each others' size and positions.
 	struct IContainer
 	{
+		friend struct LayoutScheduler;
+
 	protected:
 		virtual bool _AddChild(std::shared_ptr<IContainer> child) { return false; }
+		virtual bool _InsertChild(size_t index, std::shared_ptr<IContainer> child) { return index == NumChildren() && _AddChild(child); }
 		virtual void _RemoveChild(size_t index) { assert(false); }
 		virtual void _ClearChildren() {};
 		virtual std::shared_ptr<IContainer> _GetChild(size_t index) const { assert(false); return nullptr; }
 
+		// The child at index without touching its reference count. Override along with _GetChild.
+		virtual IContainer* _ChildAt(size_t index) const { assert(false); return nullptr; }
+
+		// The index of a child within its parent, for containers that keep one so ChildPosition is O(1).
+		inline static size_t _GetSlot(const IContainer& child) { return child._slot; }
+		inline static void _SetSlot(IContainer& child, size_t slot) { child._slot = slot; }
+
+		// This function is called by SetParentShape whenever this container needs to be laid out again.
+		// Use it to recalculate your own shapes and GUI aware types, and to pass shapes on to children.
+		virtual void _SetParentShape(const SDL::FRect& parent)
+		{
+			size_t num = NumChildren();
+
+			const SDL::FRect _shape = shape.Get(parent);
+
+			while (num)
+			{
+				ChildAt(--num).SetParentShape(_shape);
+			}
+		}
+
+		// The screen area this container draws within, not counting its children. Return false if it is
+		// not known, so the container is never culled. The default draws nothing.
+		virtual bool _DrawBounds(SDL::FRect& bounds) const
+		{
+			bounds = {};
+			return true;
+		}
+
+		// Called by SetParentShape when this container is clean but some of its children are not.
+		// Containers that cache measurements of their children can override this to refresh them.
+		virtual void _RelayoutDirtyChildren()
+		{
+			size_t num = NumChildren();
+
+			while (num)
+			{
+				IContainer& child = ChildAt(--num);
+				child.SetParentShape(child.parent_shape);
+			}
+		}
+
+		// Called by SetParentShape after _SetParentShape or _RelayoutDirtyChildren, once every subtree handed
+		// to a LayoutScheduler is laid out too. Override this, not those, to read the layout of descendants.
+		virtual void _OnSubtreeLaidOut() {}
+
 	public:
 		IContainer* parent = nullptr;
 
@@ -249,6 +385,58 @@ namespace GUI
 			{
 				assert(ChildPosition(child) != ~(size_t)0);
 				child->parent = this;
+				// The child has no valid parent shape yet, so this container lays it out again.
+				InvalidateLayout();
+				return true;
+			}
+			else
+			{
+				assert(ChildPosition(child) == ~(size_t)0);
+				child->parent = nullptr;
+				return false;
+			}
+		}
+
+		// Creates a child in pooled memory and adds it to this container, which owns it.
+		// Returns nullptr if this container does not accept the child.
+		template <typename T, typename... Args>
+		inline T* Emplace(Args&&... args)
+		{
+			std::shared_ptr<T> child = Make<T>(std::forward<Args>(args)...);
+			return AddChild(child) ? child.get() : nullptr;
+		}
+
+		// Adds a child before the child at index, or at the end if index is NumChildren().
+		// Containers without an order of children only accept insertion at the end.
+		inline bool InsertChild(size_t index, std::shared_ptr<IContainer> child)
+		{
+			if (child == nullptr) return false;
+
+			if (child->parent == this)
+			{
+				// Removing the child may move others, so the child it goes before is found again afterwards
+				const size_t num = NumChildren();
+				std::shared_ptr<IContainer> before = index < num ? GetChild(index) : nullptr;
+
+				RemoveChild(child);
+
+				if (before == nullptr) index = index == num ? NumChildren() : index;
+				else if (before != child) index = ChildPosition(before);
+			}
+			else if (child->parent != nullptr)
+			{
+				child->parent->RemoveChild(child);
+			}
+
+			if (index > NumChildren()) return false;
+
+			assert(ChildPosition(child) == ~(size_t)0);
+
+			if (_InsertChild(index, child))
+			{
+				assert(ChildPosition(child) == index);
+				child->parent = this;
+				InvalidateLayout();
 				return true;
 			}
 			else
@@ -269,6 +457,84 @@ namespace GUI
 			return child;
 		}
 
+		// The child at index, without the reference counting of GetChild. For walking the tree.
+		inline IContainer& ChildAt(size_t index) const
+		{
+			assert(index < NumChildren());
+			IContainer* child = _ChildAt(index);
+			assert(child != nullptr && child->parent == this);
+			return *child;
+		}
+
+		// Iterates over this container and its descendants, parents before children, following parent
+		// links and the index each child keeps in its parent. Neither allocates nor touches reference counts.
+		// The tree must not change during the walk.
+		struct DepthFirstIterator
+		{
+			IContainer* node;
+			IContainer* root;
+
+			inline IContainer& operator*() const { return *node; }
+			inline IContainer* operator->() const { return node; }
+
+			inline DepthFirstIterator& operator++()
+			{
+				node = _Next(*node, *root, true);
+				return *this;
+			}
+
+			inline bool operator==(const DepthFirstIterator& other) const { return node == other.node; }
+			inline bool operator!=(const DepthFirstIterator& other) const { return node != other.node; }
+		};
+
+		struct DepthFirstRange
+		{
+			IContainer* root;
+
+			inline DepthFirstIterator begin() const { return { root, root }; }
+			inline DepthFirstIterator end() const { return { nullptr, root }; }
+		};
+
+		inline DepthFirstRange DepthFirst() { return { this }; }
+
+		// Calls f on this container and its descendants, parents before children. If f returns bool,
+		// returning false skips the children of that container.
+		template <typename F>
+		inline void VisitDepthFirst(F&& f)
+		{
+			IContainer* node = this;
+
+			while (node != nullptr)
+			{
+				bool descend = true;
+
+				if constexpr (std::is_same_v<std::invoke_result_t<F&, IContainer&>, bool>) descend = f(*node);
+				else f(*node);
+
+				node = _Next(*node, *this, descend);
+			}
+		}
+
+		// Calls f on this container and its descendants, level by level. The queue is kept between walks.
+		template <typename F>
+		inline void VisitBreadthFirst(F&& f)
+		{
+			// Taken for the walk, so a walk started from f gets its own
+			std::vector<IContainer*> queue = std::move(_bfs_scratch);
+			queue.clear();
+			queue.push_back(this);
+
+			for (size_t i = 0; i < queue.size(); i++)
+			{
+				IContainer& node = *queue[i];
+				f(node);
+
+				for (size_t c = 0, n = node.NumChildren(); c < n; c++) queue.push_back(&node.ChildAt(c));
+			}
+
+			_bfs_scratch = std::move(queue);
+		}
+
 		inline void RemoveChild(std::shared_ptr<IContainer> child)
 		{
 			assert(child->parent == this);
@@ -276,6 +542,7 @@ namespace GUI
 			_RemoveChild(ChildPosition(child));
 			child->parent = nullptr;
 			assert(ChildPosition(child) == ~(size_t)0);
+			InvalidateLayout();
 		}
 
 		inline void RemoveChild(size_t index)
@@ -285,6 +552,7 @@ namespace GUI
 			_RemoveChild(index);
 			child->parent = nullptr;
 			assert(ChildPosition(child) == ~(size_t)0);
+			InvalidateLayout();
 		}
 
 		inline void ClearChildren()
@@ -293,226 +561,425 @@ namespace GUI
 			assert(NumChildren() == 0);
 		}
 
+		// Removes every container below root from its parent, deepest first. Iterative, so any depth is safe.
 		inline static void DeleteTree(IContainer* root)
 		{
 			if (root == nullptr) return;
 
-			size_t num = root->NumChildren();
+			IContainer* node = root;
 
-			while (num)
+			while (true)
 			{
-				std::shared_ptr<IContainer> child = root->GetChild(--num);
+				const size_t num = node->NumChildren();
 
-				root->RemoveChild(num);
-				assert(root->NumChildren() == num);
+				if (num != 0)
+				{
+					node = &node->ChildAt(num - 1);
+					continue;
+				}
+
+				if (node == root) return;
 
-				DeleteTree(child.get());
+				// The node is the last child of its parent, and may be destroyed by its removal
+				IContainer* p = node->parent;
+				p->RemoveChild(p->NumChildren() - 1);
+				node = p;
 			}
 		}
 
 		// The shape of this container relative to its parent.
 		GUIRect shape;
 
+		// The last parent shape received in screen coordinates.
+		SDL::FRect parent_shape = {};
+
 #ifndef DEBUG_GUI_CONTAINERS
-		
-		inline IContainer(const GUIRect& shape                    ) : shape(shape) {}
+		inline IContainer(const GUIRect& shape) : shape(shape), _last_shape(shape) {}
 		inline ~IContainer()
 		{
 			assert(parent == nullptr);
 			assert(NumChildren() == 0);
 		}
-
-		// This function is called whenever the parent of this container is reshaped.
-		// Use it to recalculate your own shapes and GUI aware types.
-		virtual void SetParentShape(const SDL::FRect& parent)
+#else
+		inline IContainer(const GUIRect& shape) : shape(shape), _last_shape(shape)
 		{
-			size_t num = NumChildren();
-
-			const SDL::FRect _shape = shape.Get(parent);
-
-			while (num)
-			{
-				GetChild(--num)->SetParentShape(_shape);
-			}
+			LayoutLock lock;
+			_debug_index = _containers.size();
+			_containers.push_back(this);
 		}
-
-#else
-		SDL::FRect parent_shape;
-
-		inline IContainer(const GUIRect& shape) : shape(shape) { _containers.push_back(this); }
 		inline ~IContainer()
 		{
-			std::remove(_containers.begin(), _containers.end(), this);
+			LayoutLock lock;
+
+			// The last container takes the place of this one
+			IContainer* last = _containers.back();
+			_containers[_debug_index] = last;
+			last->_debug_index = _debug_index;
+			_containers.pop_back();
+
 			assert(parent == nullptr);
 			assert(NumChildren() == 0);
 		}
+#endif
 
-		// This function is called whenever the parent of this container is reshaped.
-		// Use it to recalculate your own shapes and GUI aware types.
-		virtual void SetParentShape(const SDL::FRect& parent)
+		// Lays out this container within a parent shape given in screen coordinates.
+		// Work is only done if the parent shape or this container's shape changed since the last call,
+		// or if a relayout was requested with InvalidateLayout; clean subtrees are skipped.
+		inline void SetParentShape(const SDL::FRect& parent)
 		{
-			this->parent_shape = parent;
+			if (!_layout_dirty && !_child_dirty && parent == parent_shape && shape == _last_shape) return;
 
-			size_t num = NumChildren();
+			if (_scheduler != nullptr && _scheduler->Defer(*this, parent)) return;
 
-			const SDL::FRect _shape = shape.Get(parent);
+			_Layout(parent);
+		}
 
-			while (num)
+		// Requests that this container is laid out again on the next SetParentShape pass that reaches it.
+		// Call this after changing state that SetParentShape cannot observe, such as members other than shape.
+		inline void InvalidateLayout()
+		{
+			LayoutLock lock;
+
+			_layout_dirty = true;
+
+			for (IContainer* p = parent; p != nullptr && !p->_child_dirty; p = p->parent)
 			{
-				GetChild(--num)->SetParentShape(_shape);
+				p->_child_dirty = true;
 			}
 		}
 
-		// Renders corners of the relative shape within the parent before
-		// offsets are applied.
-		void RenderAnchors(SDL::Renderer& r) const
+		inline constexpr bool IsLayoutDirty() const { return _layout_dirty || _child_dirty; }
+
+		// The number of containers in this subtree, including this one, as of the last layout.
+		inline size_t SubtreeSize() const { return _subtree_size; }
+
+		// The screen area this container and all of its children draw within, as of the last layout.
+		// Returns false if some part of the subtree does not report its bounds.
+		inline bool GetSubtreeBounds(SDL::FRect& bounds) const
+		{
+			bounds = _subtree_bounds;
+			return _subtree_bounded;
+		}
+
+		struct CullStats
 		{
-			const SDL::FRect _anchor_shape = { parent_shape.pos + parent_shape.size * shape.position.anchor, parent_shape.size * shape.size.anchor };
+			// Containers reached by the walk.
+			size_t visited = 0;
+			// Subtrees skipped entirely.
+			size_t branches_culled = 0;
+		};
+
+		// Marks the elements of a laid out tree that draw within view, skipping every subtree whose bounds
+		// miss it. Once called, RenderAllGUI only renders marked elements, so call this every frame after
+		// layout, on the root of every tree being drawn.
+		inline static CullStats Cull(IContainer& root, const SDL::FRect& view)
+		{
+			GUI_PROFILE_SCOPE("Cull");
 
-			const SDL::FPoint top_left = _anchor_shape.topLeft();
-			const SDL::FPoint top_right = _anchor_shape.topRight();
-			const SDL::FPoint bot_right = _anchor_shape.bottomRight();
-			const SDL::FPoint bot_left = _anchor_shape.bottomLeft();
+			CullStats stats;
 
-			r.SetDrawColour(SDL::WHITE);
-			r.DrawLinesF({ top_left,  top_left + SDL::FPoint(-10.f, -4.f), top_left + SDL::FPoint(-4.f, -10.f), top_left });
-			r.DrawLinesF({ top_right, top_right + SDL::FPoint(4.f, -10.f), top_right + SDL::FPoint(10.f, -4.f), top_right });
-			r.DrawLinesF({ bot_right, bot_right + SDL::FPoint(10.f,   4.f), bot_right + SDL::FPoint(4.f,  10.f), bot_right });
-			r.DrawLinesF({ bot_left,  bot_left + SDL::FPoint(-4.f,  10.f), bot_left + SDL::FPoint(-10.f,   4.f), bot_left });
+			_culling = true;
+			_cull_frame++;
+			_num_culled = 0;
 
-			r.SetDrawColour(SDL::ORANGE);
-			if (_anchor_shape.w == 0)
+			root.VisitDepthFirst([&view, &stats](IContainer& node)
 			{
-				if (_anchor_shape.h == 0)
+				stats.visited++;
+
+				if (node._subtree_bounded && !_Overlaps(node._subtree_bounds, view))
 				{
-					r.DrawPointF(top_left);
+					stats.branches_culled++;
+					return false;
 				}
-				else
+
+				SDL::FRect bounds;
+				if (!node._DrawBounds(bounds) || _Overlaps(bounds, view))
 				{
-					r.DrawLineF(top_left, bot_right);
+					node._visible_frame = _cull_frame;
 				}
-			}
-			else
+
+				return true;
+			});
+
+			return stats;
+		}
+
+		// Renders every enabled element again, until the next call to Cull.
+		inline static void StopCulling() { _culling = false; }
+
+		// Hides this container and its descendants from rendering and pointer input, leaving them laid out
+		// and enabled, for containers that keep children outside their own area, such as VirtualList.
+		inline void SetHidden(bool hidden)
+		{
+			VisitDepthFirst([hidden](IContainer& c)
 			{
-				if (_anchor_shape.h == 0)
-				{
-					r.DrawLineF(top_left, bot_right);
-				}
-				else
-				{
-					r.DrawRectF(_anchor_shape);
-				}
-			}
+				if (c._hidden == hidden) return;
+
+				c._hidden = hidden;
+				c._OnHiddenChanged();
+			});
 		}
 
-		// Renders the achors of all containers that exist.
-		static void RenderAllAnchors(SDL::Renderer& r)
+		inline constexpr bool IsHidden() const { return _hidden; }
+
+		// Limits pointer input to this container and its descendants to an area, for containers that
+		// show children partly outside their own area, such as VirtualList. Drawing is not clipped.
+		inline void SetHitClip(const SDL::FRect& area)
 		{
-			for (auto c : _containers)
+			VisitDepthFirst([&area](IContainer& c)
 			{
-				c->RenderAnchors(r);
-			}
+				c._hit_clip = area;
+				c._hit_clipped = true;
+			});
 		}
 
-		// Renders outline of shape relative to stored parent in screen coordinates.
-		void RenderShape(SDL::Renderer& r) const
+		inline void ClearHitClip()
 		{
-			SDL::FRect _shape = shape.Get(parent_shape);
+			VisitDepthFirst([](IContainer& c) { c._hit_clipped = false; });
+		}
+
+		inline constexpr bool IsHitClipped() const { return _hit_clipped; }
+
+		// Whether pointer input at a point may reach this container, as limited by SetHitClip.
+		inline bool HitClipContains(const SDL::Point& point) const { return !_hit_clipped || _hit_clip.contains(point); }
+
+		// Called by PointerRouter with mouse events routed to this container or one of its children.
+		// Return true if the event was handled, false to let it bubble up to the parent.
+		virtual bool OnPointerEvent(const PointerEvent& e) { return false; }
+
+	protected:
+		inline static bool _culling = false;
+		inline static uint32_t _cull_frame = 0;
+		inline static size_t _num_culled = 0;
+
+		// The value of _cull_frame when Cull last found this container in view.
+		uint32_t _visible_frame = 0;
+
+		bool _hidden = false;
+		bool _hit_clipped = false;
+		SDL::FRect _hit_clip = {};
+
+		virtual void _OnHiddenChanged() {}
+
+		inline static bool _Overlaps(const SDL::FRect& a, const SDL::FRect& b)
+		{
+			return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+		}
+
+	private:
+		GUIRect _last_shape;
+		bool _layout_dirty = true;
+		bool _child_dirty = false;
+
+		SDL::FRect _subtree_bounds = {};
+		bool _subtree_bounded = false;
+		size_t _subtree_size = 1;
+
+		size_t _slot = ~(size_t)0;
 
-			r.SetDrawColour(SDL::AZURE);
+		inline static thread_local std::vector<IContainer*> _bfs_scratch = {};
 
-			if (_shape.w == 0)
+		// The index of a child in its parent, from its slot if the parent keeps them.
+		inline static size_t _IndexIn(const IContainer& p, const IContainer& child)
+		{
+			const size_t n = p.NumChildren();
+
+			if (child._slot < n && p._ChildAt(child._slot) == &child) return child._slot;
+
+			for (size_t i = 0; i < n; i++)
 			{
-				if (_shape.h == 0)
-				{
-					r.DrawPointF(_shape.pos);
-				}
-				else
-				{
-					r.DrawLineF(_shape.pos, _shape.pos + _shape.size);
-				}
+				if (p._ChildAt(i) == &child) return i;
 			}
-			else
+
+			assert(false);
+			return n;
+		}
+
+		// The container after node in a walk of root parents first, or nullptr at the end.
+		inline static IContainer* _Next(IContainer& node, IContainer& root, bool descend)
+		{
+			if (descend && node.NumChildren() != 0) return node._ChildAt(0);
+
+			for (IContainer* c = &node; c != &root; c = c->parent)
 			{
-				if (_shape.h == 0)
-				{
-					r.DrawLineF(_shape.pos, _shape.pos + _shape.size);
-				}
-				else
-				{
-					r.DrawRectF(_shape);
-				}
+				IContainer& p = *c->parent;
+				const size_t next = _IndexIn(p, *c) + 1;
+
+				if (next < p.NumChildren()) return p._ChildAt(next);
 			}
+
+			return nullptr;
 		}
 
-		// Renders the shapes of all containers that exist.
-		static void RenderAllShapes(SDL::Renderer& r)
+		inline static LayoutScheduler* _scheduler = nullptr;
+
+		inline void _Layout(const SDL::FRect& parent)
 		{
-			for (auto c : _containers)
+#ifdef GUI_PROFILE
+			Profiler::Scope scope;
+			if (this->parent == nullptr || _subtree_size >= Profiler::min_layout_subtree) scope.Restart("SetParentShape", "subtree", (int64_t)_subtree_size);
+#endif
+
+			LayoutScheduler* scheduler = _scheduler;
+			LayoutScheduler::Join join;
+
+			if (scheduler != nullptr) scheduler->Begin(join);
+
+			if (_layout_dirty || !(parent == parent_shape) || shape != _last_shape)
+			{
+				parent_shape = parent;
+				_last_shape = shape;
+				_layout_dirty = false;
+				_child_dirty = false;
+
+				Stats::CountLaidOut();
+				_SetParentShape(parent);
+			}
+			else
 			{
-				c->RenderShape(r);
+				_child_dirty = false;
+
+				_RelayoutDirtyChildren();
 			}
+
+			if (scheduler != nullptr) scheduler->End(join);
+
+			_OnSubtreeLaidOut();
+			_UpdateSubtreeBounds();
+
+			// Ancestors still being laid out in the same pass cover this subtree themselves
+			if (scheduler == nullptr) _GrowAncestors();
 		}
 
-		// Renders outline of last parent shape received in screen coordinates.
-		void RenderParent(SDL::Renderer& r) const
+		// Sets the bounds and size of this subtree from those of its children, which are already up to date.
+		inline void _UpdateSubtreeBounds()
 		{
-			r.SetDrawColour(SDL::RED);
+			SDL::FRect bounds;
+			bool bounded = _DrawBounds(bounds);
+
+			float x0 = bounds.x, y0 = bounds.y, x1 = bounds.x + bounds.w, y1 = bounds.y + bounds.h;
+			bool empty = bounds.w <= 0.f || bounds.h <= 0.f;
+
+			size_t size = 1;
 
-			if (parent_shape.w == 0)
+			for (size_t i = 0, n = NumChildren(); i < n; i++)
 			{
-				if (parent_shape.h == 0)
-				{
-					r.DrawPointF(parent_shape.pos);
-				}
-				else
+				const IContainer& child = *_ChildAt(i);
+
+				size += child._subtree_size;
+
+				if (!bounded) continue;
+
+				if (!child._subtree_bounded) bounded = false;
+				else if (child._subtree_bounds.w > 0.f && child._subtree_bounds.h > 0.f)
 				{
-					r.DrawLineF(parent_shape.pos, parent_shape.pos + parent_shape.size);
+					const SDL::FRect& b = child._subtree_bounds;
+
+					if (empty)
+					{
+						x0 = b.x; y0 = b.y; x1 = b.x + b.w; y1 = b.y + b.h;
+						empty = false;
+					}
+					else
+					{
+						x0 = std::min(x0, b.x);
+						y0 = std::min(y0, b.y);
+						x1 = std::max(x1, b.x + b.w);
+						y1 = std::max(y1, b.y + b.h);
+					}
 				}
 			}
-			else
+
+			_subtree_bounded = bounded;
+			_subtree_bounds = empty ? SDL::FRect() : SDL::FRect(x0, y0, x1 - x0, y1 - y0);
+			_subtree_size = size;
+		}
+
+		// Children can be laid out on their own, such as a slider moving its handle, so this grows any
+		// ancestors that no longer cover this subtree. They shrink again when next laid out.
+		inline void _GrowAncestors()
+		{
+			const bool bounded = _subtree_bounded;
+			const bool empty = _subtree_bounds.w <= 0.f || _subtree_bounds.h <= 0.f;
+			const float x0 = _subtree_bounds.x, y0 = _subtree_bounds.y;
+			const float x1 = x0 + _subtree_bounds.w, y1 = y0 + _subtree_bounds.h;
+
+			for (IContainer* p = parent; p != nullptr && p->_subtree_bounded; p = p->parent)
 			{
-				if (parent_shape.h == 0)
+				SDL::FRect& b = p->_subtree_bounds;
+
+				if (!bounded)
 				{
-					r.DrawLineF(parent_shape.pos, parent_shape.pos + parent_shape.size);
+					p->_subtree_bounded = false;
+					continue;
 				}
-				else
+
+				if (empty) break;
+
+				if (b.w <= 0.f || b.h <= 0.f)
 				{
-					r.DrawRectF(parent_shape);
+					b = _subtree_bounds;
+					continue;
 				}
-			}
-		}
 
-		// Renders the parents of all containers that exist.
-		static void RenderAllParents(SDL::Renderer& r)
-		{
-			for (auto c : _containers)
-			{
-				c->RenderParent(r);
+				if (b.x <= x0 && b.y <= y0 && b.x + b.w >= x1 && b.y + b.h >= y1) break;
+
+				const float bx1 = std::max(b.x + b.w, x1);
+				const float by1 = std::max(b.y + b.h, y1);
+
+				b.x = std::min(b.x, x0);
+				b.y = std::min(b.y, y0);
+				b.w = bx1 - b.x;
+				b.h = by1 - b.y;
 			}
 		}
 
+#ifdef DEBUG_GUI_CONTAINERS
+	public:
+		// Every container that exists, in no particular order.
+		inline static const std::vector<IContainer*>& AllContainers() { return _containers; }
+
 	private:
 		inline static std::vector<IContainer*> _containers = {};
+		// The position of this container in _containers.
+		size_t _debug_index = 0;
 #endif // DEBUG_GUI_CONTAINERS
 
 	};
 
+	inline void LayoutScheduler::_LayoutNow(IContainer& c, const SDL::FRect& parent)
+	{
+		c._Layout(parent);
+	}
+
+	inline void LayoutScheduler::_GrowAncestors(IContainer& c)
+	{
+		c._GrowAncestors();
+	}
+
+	inline void LayoutScheduler::_SetScheduler(LayoutScheduler* scheduler)
+	{
+		IContainer::_scheduler = scheduler;
+	}
+
 	// A base type for GUI components that may be rendered to the screen.
 	struct IRenderable : public IContainer
 	{
 		inline IRenderable(const GUIRect& shape, int render_order = 0, bool render_enabled = true) : IContainer(shape) {
 			_order = render_order;
 			_enabled = render_enabled;
-			_Add(*this);
+			_renderables.Add(*this, _handle, _order);
 		}
 
 		inline constexpr int GetOrder() { return _order; }
 		inline void SetOrder(int order)
 		{
-			_Remove(*this);
+			if (_order == order) return;
+
 			_order = order;
-			_Add(*this);
+			_renderables.SetOrder(_handle, _order);
+			_OnOrderChanged(_order);
+			Invalidate();
 		}
 
 		inline constexpr bool GetEnable() { return _enabled; }
@@ -520,6 +987,7 @@ namespace GUI
 		{
 			if (_enabled == enable) return;
 			_enabled = enable;
+			_Damage();
 
 			if (_enabled) OnEnable();
 			else OnDisable();
@@ -530,54 +998,178 @@ namespace GUI
 
 		~IRenderable()
 		{
-			_Remove(*this);
+			Invalidate();
+			if (_cache_owner != nullptr) _cache_owner->_OnCachedDestroyed(*this);
+			_renderables.Remove(_handle);
+		}
+
+		// Marks the screen area of this element for redrawing, such as after changing its colour.
+		inline void Invalidate()
+		{
+			if (_enabled) _Damage();
 		}
 
+		// The screen area this element draws within, as last set with SetBounds.
+		inline constexpr const SDL::FRect& GetBounds() const { return _bounds; }
+
 		virtual void RenderGUI() = 0;
 		static void RenderAllGUI()
 		{
-			for (auto& it : _renderables)
+			_RenderAll([](const IRenderable& r) { return true; });
+		}
+
+		// Renders only the elements that may draw within a region of the screen.
+		// Elements that never set their bounds are always rendered.
+		static void RenderAllGUI(const SDL::Rect& region)
+		{
+			_RenderAll([&region](const IRenderable& r)
 			{
-				for (auto r : it.second)
-				{
-					if (!r->_enabled) continue;
+				return !r._has_bounds || Damage::Intersects(r._bounds, region);
+			});
+		}
+
+		// Enabled elements skipped by RenderAllGUI since the last Cull because they were out of view.
+		// Each region rendered counts its skipped elements separately.
+		inline static size_t NumCulled() { return _num_culled; }
+
+	protected:
+		// Set by elements that only draw through RectBatch.
+		bool _batched = false;
+
+		// The element whose cached image this element draws into, instead of the screen.
+		IRenderable* _cache_owner = nullptr;
+
+		void _OnHiddenChanged() { Invalidate(); }
+
+		// Called by SetOrder, for elements keeping other state that follows the render order.
+		virtual void _OnOrderChanged(int order) {}
+
+		// Called on a cache owner when an element drawing into its image is invalidated or destroyed.
+		virtual void _OnCachedInvalidate() {}
+		virtual void _OnCachedDestroyed(IRenderable& r) {}
+
+		bool _DrawBounds(SDL::FRect& bounds) const
+		{
+			bounds = _bounds;
+			return _has_bounds;
+		}
 
-					r->RenderGUI();
+		inline static IRenderable* _GetCacheOwner(const IRenderable& r) { return r._cache_owner; }
+		inline static void _SetCacheOwner(IRenderable& r, IRenderable* owner) { r._cache_owner = owner; }
+
+		// Renders enabled elements in the order given, regardless of culling and cache owners.
+		static void _RenderEach(const std::vector<IRenderable*>& list)
+		{
+			for (size_t i = 0; i < list.size(); i++)
+			{
+				IRenderable* r = list[i];
+				if (r->_hidden) continue;
+
+				if (!r->_enabled)
+				{
+					Stats::CountDisabled();
+					continue;
 				}
+
+				if (!r->_batched || (i != 0 && list[i - 1]->_order != r->_order)) RectBatch::Flush();
+
+				r->RenderGUI();
+				Stats::CountRendered(r->_batched);
 			}
+
+			RectBatch::Flush();
+		}
+
+		// Call from _SetParentShape with the screen area this element draws within.
+		// Both the old and the new area are damaged if they differ.
+		inline void SetBounds(const SDL::FRect& bounds)
+		{
+			if (_has_bounds && bounds == _bounds) return;
+
+			Invalidate();
+			_bounds = bounds;
+			_has_bounds = true;
+			Invalidate();
 		}
 
 	private:
-		inline static std::map<int,std::vector<IRenderable*>> _renderables = {};
-		int _order = 0;
-		bool _enabled = true;
-		inline static void _Add(IRenderable& r)
+		inline static OrderedRegistry<IRenderable> _renderables = {};
+
+		// Renders the enabled elements drawn to the screen that are in view and pass a test.
+		template <typename F>
+		inline static void _RenderAll(F&& test)
 		{
-			if (_renderables.count(r._order) == 0)
+			auto render = [&test](IRenderable& r)
 			{
-				_renderables[r._order] = std::vector<IRenderable*>();
-			}
+				if (r._cache_owner != nullptr || r._hidden) return;
 
-			_renderables[r._order].push_back(&r);
+				if (!r._enabled)
+				{
+					Stats::CountDisabled();
+					return;
+				}
+
+				if (r._IsCulled())
+				{
+					Stats::CountCulled();
+					return;
+				}
+
+				if (!test(r)) return;
+
+				// Elements drawing straight to the renderer must not overtake queued rects.
+				if (!r._batched) RectBatch::Flush();
+
+				r.RenderGUI();
+				Stats::CountRendered(r._batched);
+			};
+
+			// Rects queued by one render order are drawn before the next order paints over them
+#ifdef GUI_PROFILE
+			// Each render order is also timed on its own
+			Profiler::Scope bucket;
+			_renderables.ForEach(render, [&bucket](int order)
+			{
+				RectBatch::Flush();
+				bucket.Restart("RenderAllGUI", "order", order);
+			});
+#else
+			_renderables.ForEach(render, [](int) { RectBatch::Flush(); });
+#endif
+
+			RectBatch::Flush();
+		}
+		OrderedRegistry<IRenderable>::Handle _handle;
+		int _order = 0;
+		bool _enabled = true;
+		bool _has_bounds = false;
+		SDL::FRect _bounds = {};
+
+		inline void _Damage()
+		{
+			if (_cache_owner != nullptr) _cache_owner->_OnCachedInvalidate();
+			else Damage::Add(_bounds);
 		}
-		inline static void _Remove(IRenderable& r)
+
+		inline bool _IsCulled() const
 		{
-			std::vector<IRenderable*>& _v = _renderables[r._order];
-			
-			std::remove(_v.begin(), _v.end(), &r);
+			if (!_culling || _visible_frame == _cull_frame) return false;
+
+			_num_culled++;
+			return true;
 		}
 	};
 
+	// A base type for objects that need updating each frame while they have work to do, such as a
+	// running transition. Only awake objects are updated, so the cost of UpdateAll scales with the
+	// number of running animations rather than the number of objects.
 	struct IUpdateable
 	{
-		IUpdateable()
-		{
-			_Add(*this);
-		}
+		IUpdateable() {}
 
 		~IUpdateable()
 		{
-			_Remove(*this);
+			_updateables.Remove(_handle);
 		}
 
 		inline constexpr bool GetEnable() { return _enabled; }
@@ -586,36 +1178,56 @@ namespace GUI
 			if (_enabled == enable) return;
 			_enabled = enable;
 
-			if (_enabled) OnEnable();
-			else OnDisable();
+			if (_enabled)
+			{
+				if (_awake) _updateables.Add(*this, _handle, 0);
+				OnEnable();
+			}
+			else
+			{
+				_updateables.Remove(_handle);
+				OnDisable();
+			}
 		}
 
 		virtual void OnEnable() {}
 		virtual void OnDisable() {}
 
-		virtual void Update(Uint64 dT) = 0;
+		// Adds this object to the active set, so it is updated from the next UpdateAll on.
+		inline void Wake()
+		{
+			if (_awake) return;
+			_awake = true;
+
+			if (_enabled) _updateables.Add(*this, _handle, 0);
+		}
+
+		inline constexpr bool IsAwake() const { return _awake; }
+
+		// Called every frame while awake. Return false once there is nothing left to do,
+		// and this object leaves the active set until it is woken again.
+		virtual bool Update(Uint64 dT) = 0;
 
 		inline static void UpdateAll(Uint64 dT)
 		{
-			for (auto r : _updateables)
+			GUI_PROFILE_SCOPE("IUpdateable::UpdateAll", "active", (int64_t)_updateables.Size());
+
+			_updateables.ForEach([dT](IUpdateable& u)
 			{
-				if (!r->_enabled) continue;
-				r->Update(dT);
-			}
+				if (u.Update(dT)) return;
+
+				u._awake = false;
+				_updateables.Remove(u._handle);
+			});
 		}
 
+		// The number of objects that will be updated by the next UpdateAll.
+		inline static size_t NumActive() { return _updateables.Size(); }
+
 	private:
-		inline static std::vector<IUpdateable*> _updateables = {};
+		inline static OrderedRegistry<IUpdateable> _updateables = {};
+		OrderedRegistry<IUpdateable>::Handle _handle;
 		bool _enabled = true;
-
-		inline static void _Add(IUpdateable& u)
-		{
-			_updateables.push_back(&u);
-		}
-
-		inline static void _Remove(IUpdateable& u)
-		{
-			std::remove(_updateables.begin(), _updateables.end(), &u);
-		}
+		bool _awake = false;
 	};
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
+#pragma once
 #include "GUI.hpp"
+#include "Pointer.hpp"
 #include "Lerp.hpp"
+#include "Tween.hpp"
+#include <cmath>
 
 namespace GUI
 {
@@ -7,25 +11,24 @@ namespace GUI
 	{
 		SDL::Renderer& r;
 
+		// Call Invalidate after changing this directly.
 		SDL::Colour fill_colour;
 
-		void SetParentShape(const SDL::FRect& parent)
+		inline void SetFillColour(const SDL::Colour& colour) { fill_colour = colour; Invalidate(); }
+
+		void _SetParentShape(const SDL::FRect& parent)
 		{
 			_shape = shape.Get(parent);
-
-#ifdef DEBUG_GUI_CONTAINERS
-			IRenderable::SetParentShape(parent);
-#endif
+			SetBounds(_shape);
 		}
 
 		void RenderGUI()
 		{
-			r.SetDrawColour(fill_colour);
-			r.FillRectF(_shape);
+			RectBatch::Fill(r, fill_colour, _shape);
 		}
 
 		inline FilledRect(int render_order, SDL::Renderer& r, const GUIRect& shape, SDL::Colour colour)
-			: r(r), fill_colour(colour), IRenderable(shape, render_order) {}
+			: r(r), fill_colour(colour), IRenderable(shape, render_order) { _batched = true; }
 
 	private:
 		SDL::FRect _shape;
@@ -35,25 +38,24 @@ namespace GUI
 	{
 		SDL::Renderer& r;
 
+		// Call Invalidate after changing this directly.
 		SDL::Colour border_colour;
 
-		void SetParentShape(const SDL::FRect& parent)
+		inline void SetBorderColour(const SDL::Colour& colour) { border_colour = colour; Invalidate(); }
+
+		void _SetParentShape(const SDL::FRect& parent)
 		{
 			_shape = shape.Get(parent);
-
-#ifdef DEBUG_GUI_CONTAINERS
-			IRenderable::SetParentShape(parent);
-#endif
+			SetBounds(_shape);
 		}
 
 		void RenderGUI()
 		{
-			r.SetDrawColour(border_colour);
-			r.DrawRectF(_shape);
+			RectBatch::Outline(r, border_colour, _shape);
 		}
 
 		inline BorderedRect(int render_order, SDL::Renderer& r, const GUIRect& shape, SDL::Colour colour)
-			: r(r), border_colour(colour), IRenderable(shape, render_order) {}
+			: r(r), border_colour(colour), IRenderable(shape, render_order) { _batched = true; }
 
 	private:
 		SDL::FRect _shape;
@@ -63,28 +65,27 @@ namespace GUI
 	{
 		SDL::Renderer& r;
 
+		// Call Invalidate after changing these directly.
 		SDL::Colour fill_colour;
 		SDL::Colour border_colour;
 
-		void SetParentShape(const SDL::FRect& parent)
+		inline void SetFillColour(const SDL::Colour& colour) { fill_colour = colour; Invalidate(); }
+		inline void SetBorderColour(const SDL::Colour& colour) { border_colour = colour; Invalidate(); }
+
+		void _SetParentShape(const SDL::FRect& parent)
 		{
 			_shape = shape.Get(parent);
-
-#ifdef DEBUG_GUI_CONTAINERS
-			IRenderable::SetParentShape(parent);
-#endif
+			SetBounds(_shape);
 		}
 
 		void RenderGUI()
 		{
-			r.SetDrawColour(fill_colour);
-			r.FillRectF(_shape);
-			r.SetDrawColour(border_colour);
-			r.DrawRectF(_shape);
+			RectBatch::Fill(r, fill_colour, _shape);
+			RectBatch::Outline(r, border_colour, _shape);
 		}
 
 		inline BorderedFilledRect(int render_order, SDL::Renderer& r, const GUIRect& shape, SDL::Colour fill_colour, SDL::Colour border_colour)
-			: r(r), fill_colour(fill_colour), border_colour(border_colour), IRenderable(shape, render_order) {}
+			: r(r), fill_colour(fill_colour), border_colour(border_colour), IRenderable(shape, render_order) { _batched = true; }
 
 	private:
 		SDL::FRect _shape;
@@ -97,7 +98,7 @@ namespace GUI
 
 		std::vector<std::shared_ptr<IContainer>> containers;
 
-		virtual void SetParentShape(const SDL::FRect& parent)
+		virtual void _SetParentShape(const SDL::FRect& parent)
 		{
 			SDL::FRect _shape = shape.Get(parent);
 			if (parent.w < min_size.w)
@@ -113,16 +114,50 @@ namespace GUI
 				assert(c != nullptr);
 				c->SetParentShape(_shape);
 			}
-
-#ifdef DEBUG_GUI_CONTAINERS
-			IContainer::SetParentShape(parent);
-#endif
 		}
 	};
 
-	struct FloatSlider : public IRenderable
+	enum class SliderOrientation
 	{
-		SDL::Renderer r;
+		// The handle moves along the line between the end positions in any direction.
+		FREE,
+		// The end positions are level, so only x is used to place the handle.
+		HORIZONTAL,
+		// The end positions are above one another, so only y is used to place the handle.
+		VERTICAL
+	};
+
+	// Compile time options of a Slider. Disabled options cost no code or storage.
+	template <bool ClickWarp = true, bool Quantize = false, SliderOrientation Orientation = SliderOrientation::FREE>
+	struct SliderPolicy
+	{
+		// If the user clicks anywhere in the scrollbar that is not on the knob,
+		// the knob will warp to the cursor instead of ignoring the input.
+		static constexpr bool click_warp = ClickWarp;
+		// Values snap to multiples of step from the minimum, and the knob snaps to the value when released.
+		static constexpr bool quantize = Quantize;
+		static constexpr SliderOrientation orientation = Orientation;
+	};
+
+	// Integer sliders snap to whole values by default.
+	template <typename T>
+	using DefaultSliderPolicy = SliderPolicy<true, std::is_integral_v<T>>;
+
+	template <typename T, bool quantize>
+	struct SliderStep {};
+
+	template <typename T>
+	struct SliderStep<T, true>
+	{
+		T step = 1;
+	};
+
+	template <typename T, typename Policy = DefaultSliderPolicy<T>>
+	struct Slider : public IRenderable, public SliderStep<T, Policy::quantize>
+	{
+		static_assert(std::is_arithmetic_v<T>, "Slider values must be arithmetic");
+
+		SDL::Renderer& r;
 
 		GUIPosition min_position;
 		GUIPosition max_position;
@@ -130,18 +165,17 @@ namespace GUI
 
 		GUIRect handle_shape;
 
-		float min_value;
-		float max_value;
-		float cur_value;
+		T min_value;
+		T max_value;
+		T cur_value;
 
-		// If the user clicks anywhere in the scrollbar that is not on the knob,
-		// the knob will warp to the cursor instead of ignoring the input.
-		bool click_warp;
+		SDL::Button button;
 
 		bool _AddChild(std::shared_ptr<IContainer> child)
 		{
 			if (handle_container != nullptr) return false;
 			handle_container = child;
+			_SetSlot(*child, 0);
 			return true;
 		}
 
@@ -150,6 +184,7 @@ namespace GUI
 			assert(index == 0);
 			assert(handle_container != nullptr);
 			handle_container->parent = nullptr;
+			_SetSlot(*handle_container, ~(size_t)0);
 			handle_container = nullptr;
 		}
 
@@ -158,6 +193,7 @@ namespace GUI
 			if (handle_container == nullptr) return;
 
 			handle_container->parent = nullptr;
+			_SetSlot(*handle_container, ~(size_t)0);
 			handle_container = nullptr;
 		}
 		std::shared_ptr<IContainer> _GetChild(size_t index) const
@@ -166,6 +202,11 @@ namespace GUI
 			assert(handle_container != nullptr);
 			return handle_container;
 		}
+		IContainer* _ChildAt(size_t index) const
+		{
+			assert(index == 0);
+			return handle_container.get();
+		}
 
 		size_t NumChildren() const
 		{
@@ -177,7 +218,7 @@ namespace GUI
 			return handle_container != nullptr && child == handle_container ? 0 : ~(size_t)0;
 		}
 
-		void SetParentShape(const SDL::FRect& parent)
+		void _SetParentShape(const SDL::FRect& parent)
 		{
 			_shape = shape.Get(parent);
 
@@ -193,17 +234,37 @@ namespace GUI
 				_handle_shape.size + (_max_position - _min_position)
 			);
 
-			if (handle_container != nullptr) handle_container->SetParentShape(SDL::FRect(_cur_position, _shape.size));
+			hit_region.Set(_slider_area);
+			SetBounds(_slider_area);
 
-#ifdef DEBUG_GUI_CONTAINERS
-			IRenderable::SetParentShape(parent);
-#endif
+			_PlaceHandle();
+		}
+
+		bool OnPointerEvent(const PointerEvent& e)
+		{
+			if (e.button != 0 && e.button != (Uint8)button) return false;
+
+			switch (e.type)
+			{
+			case PointerEvent::Type::DOWN:   return _OnDown(e.position);
+			case PointerEvent::Type::UP:     return _OnUp();
+			case PointerEvent::Type::MOTION: return _OnDrag(e.position);
+			default:                         return false;
+			}
+
+			return false;
+		}
+
+		// Input is routed by the same order as drawing, so the handle on top takes the click.
+		void _OnOrderChanged(int order)
+		{
+			hit_region.SetOrder(order);
 		}
 
 		void RenderGUI()
 		{
 #ifdef DEBUG_GUI_RENDER
-			if (click_warp)
+			if constexpr (Policy::click_warp)
 			{
 				r.SetDrawColour(SDL::YELLOW);
 				r.DrawRectF(_slider_area);
@@ -214,37 +275,17 @@ namespace GUI
 			r.SetDrawColour(SDL::RED);
 			r.DrawLineF(_min_position, _max_position);
 
-			if (clicker.is_clicked)
+			if (_is_clicked)
 			{
 				r.SetDrawColour(SDL::WHITE);
-				r.DrawPointF(_handle_shape.normToPoint(clicker.click_relative) + _cur_position);
+				r.DrawPointF(_handle_shape.normToPoint(_click_relative) + _cur_position);
 			}
 #endif
 		}
 
-#ifdef DEBUG_GUI_CONTAINERS
-		void RenderAnchors(SDL::Renderer& r) const
-		{
-			IRenderable::RenderAnchors(r);
-			if (handle_container != nullptr) handle_container->RenderAnchors(r);
-		}
-
-		void RenderShape(SDL::Renderer& r) const
-		{
-			IRenderable::RenderShape(r);
-			if (handle_container != nullptr) handle_container->RenderShape(r);
-		}
-
-		void RenderParent(SDL::Renderer& r) const
-		{
-			IRenderable::RenderParent(r);
-			if (handle_container != nullptr) handle_container->RenderParent(r);
-		}
-#endif
-
-		FloatSlider(SDL::Renderer& r, const GUIRect& shape, const GUIPosition& min_pos, const GUIPosition& max_pos, const GUIRect& handle_shape, float min_val, float max_val, float init_val, SDL::Button button, bool click_warp = true, int render_order = 0, bool render_enabled = true)
-			: r(r),
-			IRenderable(shape, render_order, render_enabled),
+		Slider(SDL::Renderer& r, const GUIRect& shape, const GUIPosition& min_pos, const GUIPosition& max_pos, const GUIRect& handle_shape, T min_val, T max_val, T init_val, SDL::Button button, int render_order = 0, bool render_enabled = true)
+			: IRenderable(shape, render_order, render_enabled),
+			r(r),
 			min_position(min_pos),
 			max_position(max_pos),
 			cur_position(MapRange(init_val, min_val, max_val, min_pos, max_pos)),
@@ -252,17 +293,25 @@ namespace GUI
 			min_value(min_val),
 			max_value(max_val),
 			cur_value(init_val),
-			click_warp(click_warp),
-			clicker(*this, button),
-			dragger(*this)
-		{}
+			button(button),
+			hit_region(*this, render_order)
+		{
+#ifndef DEBUG_GUI_RENDER
+			// Draws nothing outside debugging, so queued rects need not be flushed for it
+			_batched = true;
+#endif
+		}
+
+		// Click warping is chosen with SliderPolicy. Calls that still pass it after the button would
+		// otherwise convert it to the render order, so they fail to compile instead.
+		Slider(SDL::Renderer& r, const GUIRect& shape, const GUIPosition& min_pos, const GUIPosition& max_pos, const GUIRect& handle_shape, T min_val, T max_val, T init_val, SDL::Button button, bool click_warp, int render_order = 0, bool render_enabled = true) = delete;
 
-		~FloatSlider()
+		~Slider()
 		{
 			ClearChildren();
 		}
 
-		inline constexpr double GetValueNorm() const { return (cur_value - min_value) / (max_value - min_value); }
+		inline constexpr double GetValueNorm() const { return InverseLerp(cur_value, min_value, max_value); }
 
 	private:
 		std::shared_ptr<IContainer> handle_container = nullptr;
@@ -275,365 +324,150 @@ namespace GUI
 		SDL::FRect _handle_shape;
 		SDL::FRect _slider_area;
 
-		void SetFromNorm(double t)
-		{
-			cur_position = Lerp(t, min_position, max_position);
-			cur_value = Lerp(t, min_value, max_value);
-
-			_cur_position = cur_position.Get(_shape);
-
-			_handle_shape = handle_shape.Get(SDL::FRect({ 0.f,0.f }, _shape.size));
+		SDL::FPoint _click_relative;
+		bool _is_clicked = false;
 
-			if (handle_container != nullptr) handle_container->SetParentShape(SDL::FRect(_cur_position, _shape.size));
-		}
+		HitRegion hit_region;
 
-		void SetFromPosition(const SDL::FPoint& point)
+		inline void _PlaceHandle()
 		{
-			SetFromNorm(InverseLerpClamped(point - _handle_shape.normToPoint(clicker.click_relative), _min_position, _max_position));
+			if (handle_container != nullptr) handle_container->SetParentShape(SDL::FRect(_cur_position, _shape.size));
 		}
 
-		struct Clicker : SDL::IInputObserver
+		// Progress along the slider of a point, projected onto the line between the end positions.
+		inline double _Project(const SDL::FPoint& point) const
 		{
-			bool is_clicked = false;
-
-			SDL::FPoint click_relative;
-			SDL::Button button;
-
-			FloatSlider& slider;
-
-			Clicker(FloatSlider& slider, SDL::Button button)
-				: slider(slider),
-				button(button)
+			if constexpr (Policy::orientation == SliderOrientation::HORIZONTAL)
 			{
-				SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEBUTTONDOWN, *this);
-				SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEBUTTONUP, *this);
+				return InverseLerpClamped(point.x, _min_position.x, _max_position.x);
 			}
-
-			~Clicker()
+			else if constexpr (Policy::orientation == SliderOrientation::VERTICAL)
 			{
-				SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEBUTTONDOWN, *this);
-				SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEBUTTONUP, *this);
+				return InverseLerpClamped(point.y, _min_position.y, _max_position.y);
 			}
-
-			void AddSubject(SDL::IInputSubject& s) { return; }
-			void RemoveSubject(SDL::IInputSubject& s) { return; }
-
-			void Notify(const SDL::Event& e)
-			{
-				if (e.button.button != (Uint8)button) return;
-
-				if (e.button.state == SDL_RELEASED)
-				{
-					if (is_clicked)
-					{
-						is_clicked = false;
-						slider.dragger.OnRelease();
-					}
-				}
-				else
-				{
-					const SDL::Point click { e.button.x, e.button.y };
-
-					is_clicked = (slider._handle_shape + slider._cur_position).contains(click);
-
-					if (is_clicked)
-					{
-						click_relative = (slider._handle_shape + slider._cur_position).pointToNorm(click);
-
-						slider.dragger.OnClick();
-					}
-					else if (slider.click_warp)
-					{
-						is_clicked = slider._slider_area.contains(click);
-
-						if (!is_clicked) return;
-
-						const double t = InverseLerpClamped(click, slider._min_position, slider._max_position);
-
-						slider.SetFromNorm(t);
-
-						click_relative = (slider._handle_shape + slider._cur_position).pointToNorm(click);
-
-						slider.dragger.OnClick();
-					}
-				}
-			}
-
-		} clicker;
-
-		struct Dragger : SDL::InputObserver
-		{
-			FloatSlider& slider;
-
-			void OnClick()
-			{
-				SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEMOTION, *this);
-			}
-			void OnRelease()
-			{
-				SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEMOTION, *this);
-			}
-
-			void Notify(const SDL::Event& e)
+			else
 			{
-				slider.SetFromPosition(SDL::FPoint(e.motion.x, e.motion.y));
+				return InverseLerpClamped(point, _min_position, _max_position);
 			}
-
-			Dragger(FloatSlider& slider) : slider(slider) {}
-		} dragger;
-	};
-
-	struct IntSlider : public IRenderable
-	{
-		SDL::Renderer r;
-
-		GUIPosition min_position;
-		GUIPosition max_position;
-		GUIPosition cur_position;
-
-		GUIRect handle_shape;
-
-		int min_value;
-		int max_value;
-		int cur_value;
-
-		bool click_warp;
-
-		bool _AddChild(std::shared_ptr<IContainer> child)
-		{
-			if (handle_container != nullptr) return false;
-			handle_container = child;
-			return true;
-		}
-
-		void _RemoveChild(size_t index)
-		{
-			assert(index == 0);
-			assert(handle_container != nullptr);
-			handle_container->parent = nullptr;
-			handle_container = nullptr;
 		}
 
-		void _ClearChildren()
-		{
-			if (handle_container == nullptr) return;
-
-			handle_container->parent = nullptr;
-			handle_container = nullptr;
-		}
-		std::shared_ptr<IContainer> _GetChild(size_t index) const
+		inline T _Quantize(T value) const
 		{
-			assert(index == 0);
-			assert(handle_container != nullptr);
-			return handle_container;
-		}
+			const T step = this->step;
+			if (!(step > 0)) return value;
 
-		size_t NumChildren() const
-		{
-			return handle_container == nullptr ? 0 : 1;
+			const T lo = std::min(min_value, max_value);
+			const T hi = std::max(min_value, max_value);
 
-		}
-		size_t ChildPosition(std::shared_ptr<IContainer> child) const
-		{
-			return handle_container != nullptr && child == handle_container ? 0 : ~(size_t)0;
-		}
+			if constexpr (std::is_integral_v<T>)
+			{
+				// Distances are taken in the unsigned type, where they cannot overflow and stay exact
+				typedef std::make_unsigned_t<T> U;
 
-		void SetParentShape(const SDL::FRect& parent)
-		{
-			_shape = shape.Get(parent);
+				const bool up = value >= min_value;
+				const U distance = up ? (U)value - (U)min_value : (U)min_value - (U)value;
+				const U room = up ? (hi > min_value ? (U)hi - (U)min_value : 0) : (min_value > lo ? (U)min_value - (U)lo : 0);
 
-			_min_position = min_position.Get(_shape);
-			_max_position = max_position.Get(_shape);
-			_cur_position = cur_position.Get(_shape);
+				U steps = distance / (U)step;
+				const U rest = distance % (U)step;
+				if (rest >= (U)step - rest) steps++;
 
-			_handle_shape = handle_shape.Get(SDL::FRect({ 0.f,0.f }, _shape.size));
+				// Rounding past the end, or by more than U holds, lands on the end
+				if (steps > room / (U)step) return up ? hi : lo;
 
-			_slider_area = SDL::FRect
-			(
-				_handle_shape.pos + _min_position,
-				_handle_shape.size + (_max_position - _min_position)
-			);
-
-			if (handle_container != nullptr) handle_container->SetParentShape(SDL::FRect(_cur_position, _shape.size));
-		}
-
-		void RenderGUI()
-		{
-#ifdef DEBUG_GUI_RENDER
-			if (click_warp)
-			{
-				r.SetDrawColour(SDL::YELLOW);
-				r.DrawRectF(_slider_area);
+				const U offset = steps * (U)step;
+				return (T)(up ? (U)min_value + offset : (U)min_value - offset);
 			}
-
-			r.SetDrawColour(SDL::GREEN);
-			r.DrawRectF(_handle_shape + _cur_position);
-			r.SetDrawColour(SDL::RED);
-			r.DrawLineF(_min_position, _max_position);
-
-			if (clicker.is_clicked)
+			else
 			{
-				r.SetDrawColour(SDL::WHITE);
-				r.DrawPointF(_handle_shape.normToPoint(clicker.click_relative) + _cur_position);
-			}
-#endif
-		}
-
-		IntSlider(SDL::Renderer& r, const GUIRect& shape, const GUIPosition& min_pos, const GUIPosition& max_pos, const GUIRect& handle_shape, std::shared_ptr<IContainer> handle, int min_val, int max_val, int init_val, SDL::Button button, bool click_warp = true, int render_order = 0, bool render_enable = true)
-			: r(r),
-			IRenderable(shape, render_order, render_enable),
-			min_position(min_pos),
-			max_position(max_pos),
-			cur_position(MapRange(init_val, min_val, max_val, min_pos, max_pos)),
-			handle_shape(handle_shape),
-			min_value(min_val),
-			max_value(max_val),
-			cur_value(init_val),
-			click_warp(click_warp),
-			clicker(*this, button),
-			dragger(*this)
-		{}
+				// Wide enough that the difference of any two values is finite
+				const long double steps = std::round(((long double)value - (long double)min_value) / step);
 
-		~IntSlider()
-		{
-			ClearChildren();
+				return (T)std::clamp((long double)min_value + steps * step, (long double)lo, (long double)hi);
+			}
 		}
 
-		inline constexpr double GetValueNorm() const { return (cur_value - min_value) / (max_value - min_value); }
-
-	private:
-		std::shared_ptr<IContainer> handle_container = nullptr;
-
-		SDL::FRect _shape;
-
-		SDL::FPoint _min_position;
-		SDL::FPoint _max_position;
-		SDL::FPoint _cur_position;
-		SDL::FRect _handle_shape;
-		SDL::FRect _slider_area;
-
 		void SetFromNorm(double t)
 		{
 			cur_position = Lerp(t, min_position, max_position);
 			cur_value = Lerp(t, min_value, max_value);
 
+			if constexpr (Policy::quantize) cur_value = _Quantize(cur_value);
+
 			_cur_position = cur_position.Get(_shape);
 
-			_handle_shape = handle_shape.Get(SDL::FRect({ 0.f,0.f }, _shape.size));
+			_PlaceHandle();
 
-			if (handle_container != nullptr) handle_container->SetParentShape(SDL::FRect(_cur_position, _shape.size));
+			Invalidate();
 		}
 
 		void SetFromPosition(const SDL::FPoint& point)
 		{
-			SetFromNorm(InverseLerpClamped(point - _handle_shape.normToPoint(clicker.click_relative), _min_position, _max_position));
+			SetFromNorm(_Project(point - _handle_shape.normToPoint(_click_relative)));
 		}
 
-		struct Clicker : SDL::IInputObserver
+		bool _OnDown(const SDL::Point& click)
 		{
-			bool is_clicked = false;
-
-			SDL::FPoint click_relative;
-			SDL::Button button;
-
-			IntSlider& slider;
-
-			Clicker(IntSlider& slider, SDL::Button button)
-				: slider(slider),
-				button(button)
-			{
-				SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEBUTTONDOWN, *this);
-				SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEBUTTONUP, *this);
-			}
-
-			~Clicker()
-			{
-				SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEBUTTONDOWN, *this);
-				SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEBUTTONUP, *this);
-			}
+			const SDL::FRect handle = _handle_shape + _cur_position;
 
-			void AddSubject(SDL::IInputSubject& s) { return; }
-			void RemoveSubject(SDL::IInputSubject& s) { return; }
+			_is_clicked = handle.contains(click);
 
-			void Notify(const SDL::Event& e)
+			if constexpr (Policy::click_warp)
 			{
-				if (e.button.button != (Uint8)button) return;
-
-				if (e.button.state == SDL_RELEASED)
+				if (!_is_clicked)
 				{
-					if (is_clicked)
-					{
-						is_clicked = false;
-						slider.dragger.OnRelease();
-					}
-				}
-				else
-				{
-					const SDL::Point click { e.button.x, e.button.y };
-
-					is_clicked = (slider._handle_shape + slider._cur_position).contains(click);
+					_is_clicked = _slider_area.contains(click);
 
-					if (is_clicked)
-					{
-						click_relative = (slider._handle_shape + slider._cur_position).pointToNorm(click);
+					if (!_is_clicked) return false;
 
-						slider.dragger.OnClick();
-					}
-					else if (slider.click_warp)
-					{
-						is_clicked = slider._slider_area.contains(click);
+					SetFromNorm(_Project(SDL::FPoint(click.x, click.y)));
+				}
+			}
 
-						if (!is_clicked) return;
+			if (!_is_clicked) return false;
 
-						const double t = InverseLerpClamped(click, slider._min_position, slider._max_position);
+			_click_relative = (_handle_shape + _cur_position).pointToNorm(click);
 
-						slider.SetFromNorm(t);
+			PointerRouter::SetCapture(*this);
+			Invalidate();
 
-						click_relative = (slider._handle_shape + slider._cur_position).pointToNorm(click);
+			return true;
+		}
 
-						slider.dragger.OnClick();
-					}
-				}
-			}
+		bool _OnUp()
+		{
+			if (!_is_clicked) return false;
 
-		} clicker;
+			_is_clicked = false;
 
-		struct Dragger : SDL::InputObserver
-		{
-			IntSlider& slider;
+			PointerRouter::ReleaseCapture(*this);
+			Invalidate();
 
-			void OnClick()
-			{
-				SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEMOTION, *this);
-			}
-			void OnRelease()
+			if constexpr (Policy::quantize)
 			{
-				SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEMOTION, *this);
-
-				slider.cur_position = MapRange
-				(
-					slider.cur_value,
-					slider.min_value,
-					slider.max_value,
-					slider.min_position,
-					slider.max_position
-				);
+				cur_position = MapRange(cur_value, min_value, max_value, min_position, max_position);
 
-				slider._cur_position = slider.cur_position.Get(slider._shape);
+				_cur_position = cur_position.Get(_shape);
 
-				if (slider.handle_container != nullptr) slider.handle_container->SetParentShape(SDL::FRect(slider._cur_position, slider._shape.size));
+				_PlaceHandle();
 			}
 
-			void Notify(const SDL::Event& e)
-			{
-				slider.SetFromPosition(SDL::FPoint(e.motion.x, e.motion.y));
-			}
+			return true;
+		}
+
+		bool _OnDrag(const SDL::Point& position)
+		{
+			if (!_is_clicked) return false;
 
-			Dragger(IntSlider& slider) : slider(slider) {}
-		} dragger;
+			SetFromPosition(SDL::FPoint(position.x, position.y));
+			return true;
+		}
 	};
 
-	struct Toggle : public IUpdateable, public IRenderable
+	typedef Slider<float> FloatSlider;
+	typedef Slider<int> IntSlider;
+
+	struct Toggle : public IRenderable
 	{
 		SDL::Renderer r;
 
@@ -644,13 +478,16 @@ namespace GUI
 		GUIRect click_area;
 
 		Uint64 scroll_time;
+		Ease easing = Ease::LINEAR;
 
+		// Change this with SetState, so the handle moves.
 		bool state = false;
 
 		bool _AddChild(std::shared_ptr<IContainer> child)
 		{
 			if (handle_container != nullptr) return false;
 			handle_container = child;
+			_SetSlot(*child, 0);
 			return true;
 		}
 
@@ -659,6 +496,7 @@ namespace GUI
 			assert(index == 0);
 			assert(handle_container != nullptr);
 			handle_container->parent = nullptr;
+			_SetSlot(*handle_container, ~(size_t)0);
 			handle_container = nullptr;
 		}
 
@@ -667,6 +505,7 @@ namespace GUI
 			if (handle_container == nullptr) return;
 
 			handle_container->parent = nullptr;
+			_SetSlot(*handle_container, ~(size_t)0);
 			handle_container = nullptr;
 		}
 		std::shared_ptr<IContainer> _GetChild(size_t index) const
@@ -675,6 +514,11 @@ namespace GUI
 			assert(handle_container != nullptr);
 			return handle_container;
 		}
+		IContainer* _ChildAt(size_t index) const
+		{
+			assert(index == 0);
+			return handle_container.get();
+		}
 
 		size_t NumChildren() const
 		{
@@ -695,15 +539,22 @@ namespace GUI
 			click_area(click_area),
 			state(state),
 			scroll_time(scroll_time),
-			_t(state ? scroll_time : 0), IUpdateable(),
-			clicker(*this, button) {}
+			clicker(*this, button),
+			hit_region(*this, render_order)
+		{
+#ifndef DEBUG_GUI_RENDER
+			// Draws nothing outside debugging, so queued rects need not be flushed for it
+			_batched = true;
+#endif
+		}
 
 		~Toggle()
 		{
+			Tweens::Stop(&cur_position);
 			ClearChildren();
 		}
 
-		void SetParentShape(const SDL::FRect& parent)
+		void _SetParentShape(const SDL::FRect& parent)
 		{
 			_shape = shape.Get(parent);
 
@@ -713,42 +564,44 @@ namespace GUI
 
 			_click_area = click_area.Get(_shape);
 
+			hit_region.Set(_click_area);
+			SetBounds(_click_area);
+
 			if (handle_container != nullptr) handle_container->SetParentShape(SDL::FRect(_cur_position, _shape.size));
 		}
 
-		void Update(Uint64 dT)
+		bool OnPointerEvent(const PointerEvent& e)
 		{
-			if (scroll_time == 0)
-			{
-				_t = 0;
+			return clicker.Notify(e);
+		}
 
-				if (state)
-				{
-					 cur_position =  on_position;
-					_cur_position = _on_position;
-				}
-				else
-				{
-					 cur_position =  off_position;
-					_cur_position = _off_position;
-				}
-			}
-			else
-			{
-				if (state)
-				{
-					_t = scroll_time - _t > dT ? _t + dT : scroll_time;
-				}
-				else
-				{
-					_t = _t > dT ? _t - dT : 0;
-				}
+		// Flips the toggle, starting the handle moving towards the other end.
+		inline void SetState(bool new_state)
+		{
+			if (state == new_state) return;
+
+			state = new_state;
+
+			const GUIPosition& target = state ? on_position : off_position;
 
-				cur_position  = LerpClamped(_t / (double)scroll_time,  off_position,  on_position);
-				_cur_position = LerpClamped(_t / (double)scroll_time, _off_position, _on_position);
+			// Turning back part way takes the share of scroll_time left in the distance to travel
+			const SDL::FPoint from = cur_position.Get(_shape), to = target.Get(_shape);
+			const SDL::FPoint full = on_position.Get(_shape) - off_position.Get(_shape);
+			const double full_distance = std::hypot(full.x, full.y);
+
+			Uint64 duration = scroll_time;
+			if (full_distance > 0.0)
+			{
+				const double share = std::min(1.0, std::hypot(to.x - from.x, to.y - from.y) / full_distance);
+				duration = (Uint64)std::llround(scroll_time * share);
 			}
 
-			if (handle_container != nullptr) handle_container->SetParentShape(SDL::FRect(_cur_position, _shape.size));
+			Tweens::To(cur_position, target, duration, easing, this);
+		}
+
+		void _OnOrderChanged(int order)
+		{
+			hit_region.SetOrder(order);
 		}
 
 		void RenderGUI()
@@ -773,9 +626,7 @@ namespace GUI
 
 		SDL::FRect _click_area;
 
-		Uint64 _t = 0;
-
-		struct Clicker : SDL::IInputObserver
+		struct Clicker
 		{
 			SDL::Button button;
 
@@ -783,61 +634,117 @@ namespace GUI
 
 			Clicker(Toggle& toggle, SDL::Button button)
 				: toggle(toggle),
-				button(button)
-			{
-				SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEBUTTONUP, *this);
-			}
-
-			~Clicker()
-			{
-				SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEBUTTONUP, *this);
-			}
-
-			void AddSubject(SDL::IInputSubject& s) { return; }
-			void RemoveSubject(SDL::IInputSubject& s) { return; }
+				button(button) {}
 
-			void Notify(const SDL::Event& e)
+			bool Notify(const PointerEvent& e)
 			{
-				if (e.button.button != (Uint8)button) return;
+				if (e.button != (Uint8)button) return false;
+				if (e.type != PointerEvent::Type::UP) return false;
 
-				const SDL::Point click { e.button.x, e.button.y };
+				if (!toggle._click_area.contains(e.position)) return false;
 
-				if (!toggle._click_area.contains(click)) return;
-
-				toggle.state = !toggle.state;
+				toggle.SetState(!toggle.state);
+				return true;
 			}
 
 		} clicker;
+
+		HitRegion hit_region;
 	};
 
+	// A container holding any number of children. Each child stores its index, so finding and adding
+	// a child is O(1). Removing keeps the order of the rest, renumbering those after the removed child;
+	// RemoveChildUnordered removes in O(1) instead, by moving the last child into its place.
 	struct ContainerGroup : public IContainer
 	{
 	protected:
 		std::vector<std::shared_ptr<IContainer>> _children = {};
 
-		bool _AddChild(std::shared_ptr<IContainer> child) { _children.push_back(child); return true; }
-		void _RemoveChild(size_t index) { assert(index < _children.size()); _children.erase(std::next(_children.begin(), index)); }
+		bool _AddChild(std::shared_ptr<IContainer> child)
+		{
+			_SetSlot(*child, _children.size());
+			_children.push_back(child);
+			return true;
+		}
+
+		bool _InsertChild(size_t index, std::shared_ptr<IContainer> child)
+		{
+			_children.insert(std::next(_children.begin(), index), child);
+			_Renumber(index);
+			return true;
+		}
+
+		// Children keep their order, which decides the draw order of elements sharing a render order.
+		void _RemoveChild(size_t index)
+		{
+			assert(index < _children.size());
+
+			_SetSlot(*_children[index], ~(size_t)0);
+			_children.erase(std::next(_children.begin(), index));
+			_Renumber(index);
+		}
+
+		// Moves the last child into the place of the removed one, so no other children shift.
+		// Containers whose layout depends on the order of their children remove in order instead.
+		virtual void _RemoveChildUnordered(size_t index)
+		{
+			assert(index < _children.size());
+
+			_SetSlot(*_children[index], ~(size_t)0);
+
+			if (index + 1 != _children.size())
+			{
+				_children[index] = std::move(_children.back());
+				_SetSlot(*_children[index], index);
+			}
+
+			_children.pop_back();
+		}
+
 		void _ClearChildren()
 		{
 			for (auto& c : _children)
 			{
 				c->parent = nullptr;
+				_SetSlot(*c, ~(size_t)0);
 			}
 
 			_children.clear();
 		}
+
+		inline void _Renumber(size_t from)
+		{
+			for (size_t i = from; i < _children.size(); i++) _SetSlot(*_children[i], i);
+		}
 		std::shared_ptr<IContainer> _GetChild(size_t index) const
 		{
 			assert(index < _children.size());
 			return _children[index];
 		}
+		IContainer* _ChildAt(size_t index) const
+		{
+			assert(index < _children.size());
+			return _children[index].get();
+		}
 
 	public:
 		size_t NumChildren() const { return _children.size(); }
 		size_t ChildPosition(std::shared_ptr<IContainer> child) const
 		{
-			auto it = std::find(_children.begin(), _children.end(), child);
-			return it == _children.end() ? ~(size_t)0 : it - _children.begin();
+			const size_t slot = _GetSlot(*child);
+			return slot < _children.size() && _children[slot] == child ? slot : ~(size_t)0;
+		}
+
+		// Removes a child in constant time by moving the last child into its place, for large groups
+		// where the order of siblings does not matter.
+		inline void RemoveChildUnordered(size_t index)
+		{
+			std::shared_ptr<IContainer> child = _GetChild(index);
+
+			_RemoveChildUnordered(index);
+			child->parent = nullptr;
+			assert(ChildPosition(child) == ~(size_t)0);
+			InvalidateLayout();
 		}
 
 		inline IContainer& Contents() { return *this; }
@@ -849,11 +756,8 @@ namespace GUI
 			ClearChildren();
 		}
 
-		virtual void SetParentShape(const SDL::FRect& parent)
+		virtual void _SetParentShape(const SDL::FRect& parent)
 		{
-#ifdef DEBUG_GUI_CONTAINERS
-			IContainer::SetParentShape(parent);
-#endif
 			const SDL::FRect _shape = shape.Get(parent);
 
 			for (auto& c : _children)
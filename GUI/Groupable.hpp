@@ -1,3 +1,7 @@
+#pragma once
+#include <type_traits>
+#include <vector>
+
 template <typename T>
 struct Groupable
 {
@@ -7,6 +11,13 @@ protected:
 	virtual void _ClearChildren() {};
 	virtual std::shared_ptr<Groupable<T>> _GetChild(size_t index) const { assert(false); return nullptr; }
 
+	// The child at index without touching its reference count, for walking the tree.
+	virtual Groupable<T>* _ChildAt(size_t index) const = 0;
+
+	// The index of a child within its parent, for groups that keep one so walks do not search for it.
+	inline static size_t _GetSlot(const Groupable<T>& child) { return child._slot; }
+	inline static void _SetSlot(Groupable<T>& child, size_t slot) { child._slot = slot; }
+
 public:
 	Groupable<T>* parent = nullptr;
 
@@ -56,6 +67,84 @@ public:
 		return child;
 	}
 
+	// The child at index, without the reference counting of GetChild. For walking the tree.
+	inline Groupable<T>& ChildAt(size_t index) const
+	{
+		assert(index < NumChildren());
+		Groupable<T>* child = _ChildAt(index);
+		assert(child != nullptr && child->parent == this);
+		return *child;
+	}
+
+	// Iterates over this node and its descendants, parents before children, following parent links
+	// and the index of each child. Neither allocates nor touches reference counts.
+	// The tree must not change during the walk.
+	struct DepthFirstIterator
+	{
+		Groupable<T>* node;
+		Groupable<T>* root;
+
+		inline Groupable<T>& operator*() const { return *node; }
+		inline Groupable<T>* operator->() const { return node; }
+
+		inline DepthFirstIterator& operator++()
+		{
+			node = _Next(*node, *root, true);
+			return *this;
+		}
+
+		inline bool operator==(const DepthFirstIterator& other) const { return node == other.node; }
+		inline bool operator!=(const DepthFirstIterator& other) const { return node != other.node; }
+	};
+
+	struct DepthFirstRange
+	{
+		Groupable<T>* root;
+
+		inline DepthFirstIterator begin() const { return { root, root }; }
+		inline DepthFirstIterator end() const { return { nullptr, root }; }
+	};
+
+	inline DepthFirstRange DepthFirst() { return { this }; }
+
+	// Calls f on this node and its descendants, parents before children. If f returns bool,
+	// returning false skips the children of that node.
+	template <typename F>
+	inline void VisitDepthFirst(F&& f)
+	{
+		Groupable<T>* node = this;
+
+		while (node != nullptr)
+		{
+			bool descend = true;
+
+			if constexpr (std::is_same_v<std::invoke_result_t<F&, Groupable<T>&>, bool>) descend = f(*node);
+			else f(*node);
+
+			node = _Next(*node, *this, descend);
+		}
+	}
+
+	// Calls f on this node and its descendants, level by level. The queue is kept between walks.
+	template <typename F>
+	inline void VisitBreadthFirst(F&& f)
+	{
+		// Taken for the walk, so a walk started from f gets its own
+		std::vector<Groupable<T>*> queue = std::move(_bfs_scratch);
+		queue.clear();
+		queue.push_back(this);
+
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			Groupable<T>& node = *queue[i];
+			f(node);
+
+			for (size_t c = 0, n = node.NumChildren(); c < n; c++) queue.push_back(node._ChildAt(c));
+		}
+
+		_bfs_scratch = std::move(queue);
+	}
+
 	inline void RemoveChild(std::shared_ptr<Groupable<T>> child)
 	{
 		assert(child->parent == this);
@@ -80,20 +169,29 @@ public:
 		assert(NumChildren() == 0);
 	}
 
+	// Removes every node below root from its parent, deepest first. Iterative, so any depth is safe.
 	inline static void DeleteTree(Groupable<T>* root)
 	{
 		if (root == nullptr) return;
 
-		size_t num = root->NumChildren();
+		Groupable<T>* node = root;
 
-		while (num)
+		while (true)
 		{
-			std::shared_ptr<Groupable<T>> child = root->GetChild(--num);
+			const size_t num = node->NumChildren();
 
-			root->RemoveChild(num);
-			assert(root->NumChildren() == num);
+			if (num != 0)
+			{
+				node = &node->ChildAt(num - 1);
+				continue;
+			}
 
-			DeleteTree(child.get());
+			if (node == root) return;
+
+			// The node is the last child of its parent, and may be destroyed by its removal
+			Groupable<T>* p = node->parent;
+			p->RemoveChild(p->NumChildren() - 1);
+			node = p;
 		}
 	}
 
@@ -102,4 +200,41 @@ public:
 		assert(parent == nullptr);
 		assert(NumChildren() == 0);
 	}
+
+private:
+	size_t _slot = ~(size_t)0;
+
+	inline static thread_local std::vector<Groupable<T>*> _bfs_scratch = {};
+
+	// The index of a child in its parent, from its slot if the parent keeps them.
+	inline static size_t _IndexIn(const Groupable<T>& p, const Groupable<T>& child)
+	{
+		const size_t n = p.NumChildren();
+
+		if (child._slot < n && p._ChildAt(child._slot) == &child) return child._slot;
+
+		for (size_t i = 0; i < n; i++)
+		{
+			if (p._ChildAt(i) == &child) return i;
+		}
+
+		assert(false);
+		return n;
+	}
+
+	// The node after node in a walk of root parents first, or nullptr at the end.
+	inline static Groupable<T>* _Next(Groupable<T>& node, Groupable<T>& root, bool descend)
+	{
+		if (descend && node.NumChildren() != 0) return node._ChildAt(0);
+
+		for (Groupable<T>* c = &node; c != &root; c = c->parent)
+		{
+			Groupable<T>& p = *c->parent;
+			const size_t next = _IndexIn(p, *c) + 1;
+
+			if (next < p.NumChildren()) return p._ChildAt(next);
+		}
+
+		return nullptr;
+	}
 };
\ No newline at end of file
@@ -0,0 +1,398 @@
+#pragma once
+#include "GUI.hpp"
+#include "RectBatch.hpp"
+#include "Simd.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+namespace GUI
+{
+	// Bulk storage for large hierarchies of plain GUIRects.
+	// Shapes are kept as structure-of-arrays sorted by depth, so each level of the hierarchy is
+	// one contiguous run that is evaluated with SIMD once the level above it is known.
+	// Results are identical to evaluating each GUIRect against its parent with GUIRect::Get, as long as
+	// the compiler does not fuse multiplies and adds (-ffp-contract=off, as CMakeLists.txt sets).
+	struct LayoutStore
+	{
+		typedef uint32_t Handle;
+		static constexpr Handle npos = ~(Handle)0;
+
+		// Adds a rect to the store. The parent must already be in the store, or npos for a rect
+		// evaluated against the root shape.
+		Handle Add(const GUIRect& shape, Handle parent = npos)
+		{
+			assert(parent == npos || _IsAlive(parent));
+
+			Handle h;
+
+			if (_free.empty())
+			{
+				h = (Handle)_slot.size();
+				_slot.push_back(npos);
+				_parent.push_back(npos);
+				_depth.push_back(0);
+				_num_children.push_back(0);
+			}
+			else
+			{
+				h = _free.back();
+				_free.pop_back();
+			}
+
+			_parent[h] = parent;
+			_depth[h] = parent == npos ? 0 : _depth[parent] + 1;
+			_num_children[h] = 0;
+			if (parent != npos) _num_children[parent]++;
+
+			_slot[h] = (Handle)_handle.size();
+			_handle.push_back(h);
+			_parent_slot.push_back(parent == npos ? npos : _slot[parent]);
+			_PushShape(shape);
+			_sorted = false;
+
+			return h;
+		}
+
+		// Removes a rect from the store. Its children must be removed first.
+		void Remove(Handle h)
+		{
+			assert(_IsAlive(h));
+			assert(_num_children[h] == 0);
+
+			if (_parent[h] != npos) _num_children[_parent[h]]--;
+
+			_handle[_slot[h]] = npos;
+			_slot[h] = npos;
+			_free.push_back(h);
+			_sorted = false;
+		}
+
+		void Set(Handle h, const GUIRect& shape)
+		{
+			assert(_IsAlive(h));
+
+			const size_t i = _slot[h];
+
+			_pos_anchor_x[i] = shape.position.anchor.x;
+			_pos_anchor_y[i] = shape.position.anchor.y;
+			_pos_offset_x[i] = shape.position.offset.x;
+			_pos_offset_y[i] = shape.position.offset.y;
+			_size_anchor_x[i] = shape.size.anchor.x;
+			_size_anchor_y[i] = shape.size.anchor.y;
+			_size_offset_x[i] = shape.size.offset.x;
+			_size_offset_y[i] = shape.size.offset.y;
+		}
+
+		// The rect in screen coordinates from the last call to Evaluate.
+		SDL::FRect Get(Handle h) const
+		{
+			assert(_IsAlive(h));
+
+			const size_t i = _slot[h];
+
+			return SDL::FRect(_x[i], _y[i], _w[i], _h[i]);
+		}
+
+		inline size_t Size() const { return _slot.size() - _free.size(); }
+
+		// Calls f(handle, rect) for each rect from the last call to Evaluate, parents before children.
+		template <typename F>
+		void ForEach(F&& f) const
+		{
+			for (size_t i = 0; i < _handle.size(); i++)
+			{
+				if (_handle[i] != npos) f(_handle[i], SDL::FRect(_x[i], _y[i], _w[i], _h[i]));
+			}
+		}
+
+		// Evaluates every rect in the store against the root shape, one level at a time.
+		void Evaluate(const SDL::FRect& root)
+		{
+			if (!_sorted) _Sort();
+
+			for (size_t level = 0; level + 1 < _levels.size(); level++)
+			{
+				const size_t begin = _levels[level];
+				const size_t end = _levels[level + 1];
+
+				_Gather(root, begin, end);
+				_Kernel(begin, end);
+			}
+		}
+
+	private:
+		// Per handle
+		std::vector<Handle> _slot;
+		std::vector<Handle> _parent;
+		std::vector<uint32_t> _depth;
+		std::vector<uint32_t> _num_children;
+		std::vector<Handle> _free;
+
+		// Per slot, sorted by depth once _sorted is set
+		std::vector<Handle> _handle;
+		std::vector<Handle> _parent_slot;
+		std::vector<float> _pos_anchor_x, _pos_anchor_y, _pos_offset_x, _pos_offset_y;
+		std::vector<float> _size_anchor_x, _size_anchor_y, _size_offset_x, _size_offset_y;
+		std::vector<float> _parent_x, _parent_y, _parent_w, _parent_h;
+		std::vector<float> _x, _y, _w, _h;
+
+		// Slot ranges of each level, with a trailing end marker
+		std::vector<size_t> _levels;
+		bool _sorted = true;
+
+		inline bool _IsAlive(Handle h) const { return h < _slot.size() && _slot[h] != npos; }
+
+		void _PushShape(const GUIRect& shape)
+		{
+			_pos_anchor_x.push_back(shape.position.anchor.x);
+			_pos_anchor_y.push_back(shape.position.anchor.y);
+			_pos_offset_x.push_back(shape.position.offset.x);
+			_pos_offset_y.push_back(shape.position.offset.y);
+			_size_anchor_x.push_back(shape.size.anchor.x);
+			_size_anchor_y.push_back(shape.size.anchor.y);
+			_size_offset_x.push_back(shape.size.offset.x);
+			_size_offset_y.push_back(shape.size.offset.y);
+			_parent_x.push_back(0.f);
+			_parent_y.push_back(0.f);
+			_parent_w.push_back(0.f);
+			_parent_h.push_back(0.f);
+			_x.push_back(0.f);
+			_y.push_back(0.f);
+			_w.push_back(0.f);
+			_h.push_back(0.f);
+		}
+
+		template <typename T>
+		static void _Permute(std::vector<T>& v, const std::vector<Handle>& order)
+		{
+			std::vector<T> out;
+			out.reserve(order.size());
+			for (Handle i : order) out.push_back(v[i]);
+			v.swap(out);
+		}
+
+		// Reorders slots by depth, keeping siblings together in the order of their parents.
+		void _Sort()
+		{
+			std::vector<std::vector<Handle>> by_depth;
+
+			for (size_t i = 0; i < _handle.size(); i++)
+			{
+				const Handle h = _handle[i];
+				if (h == npos) continue;
+
+				const uint32_t d = _depth[h];
+				if (by_depth.size() <= d) by_depth.resize(d + 1);
+				by_depth[d].push_back((Handle)i);
+			}
+
+			std::vector<Handle> order;
+			order.reserve(Size());
+			_levels.clear();
+
+			for (auto& level : by_depth)
+			{
+				// Slots of the level above have already been reassigned
+				std::stable_sort(level.begin(), level.end(), [this](Handle a, Handle b)
+				{
+					return _ParentSlot(a) < _ParentSlot(b);
+				});
+
+				_levels.push_back(order.size());
+
+				for (Handle i : level)
+				{
+					_slot[_handle[i]] = (Handle)order.size();
+					order.push_back(i);
+				}
+			}
+
+			_levels.push_back(order.size());
+
+			_Permute(_handle, order);
+			_Permute(_pos_anchor_x, order);
+			_Permute(_pos_anchor_y, order);
+			_Permute(_pos_offset_x, order);
+			_Permute(_pos_offset_y, order);
+			_Permute(_size_anchor_x, order);
+			_Permute(_size_anchor_y, order);
+			_Permute(_size_offset_x, order);
+			_Permute(_size_offset_y, order);
+			_parent_x.resize(order.size());
+			_parent_y.resize(order.size());
+			_parent_w.resize(order.size());
+			_parent_h.resize(order.size());
+			_x.resize(order.size());
+			_y.resize(order.size());
+			_w.resize(order.size());
+			_h.resize(order.size());
+
+			_parent_slot.resize(order.size());
+			for (size_t i = 0; i < order.size(); i++)
+			{
+				const Handle p = _parent[_handle[i]];
+				_parent_slot[i] = p == npos ? npos : _slot[p];
+			}
+
+			_sorted = true;
+		}
+
+		inline Handle _ParentSlot(Handle old_slot) const
+		{
+			const Handle p = _parent[_handle[old_slot]];
+			return p == npos ? npos : _slot[p];
+		}
+
+		void _Gather(const SDL::FRect& root, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				const Handle p = _parent_slot[i];
+
+				if (p == npos)
+				{
+					_parent_x[i] = root.x;
+					_parent_y[i] = root.y;
+					_parent_w[i] = root.w;
+					_parent_h[i] = root.h;
+				}
+				else
+				{
+					_parent_x[i] = _x[p];
+					_parent_y[i] = _y[p];
+					_parent_w[i] = _w[p];
+					_parent_h[i] = _h[p];
+				}
+			}
+		}
+
+		// Same operations in the same order as GUIRect::Get, so results match bit for bit
+		// when neither is contracted into fused multiply-adds.
+		void _Kernel(size_t begin, size_t end)
+		{
+			size_t i = begin;
+
+#ifdef GUI_SIMD_AVX
+			for (; i + 8 <= end; i += 8)
+			{
+				const __m256 px = _mm256_loadu_ps(&_parent_x[i]);
+				const __m256 py = _mm256_loadu_ps(&_parent_y[i]);
+				const __m256 pw = _mm256_loadu_ps(&_parent_w[i]);
+				const __m256 ph = _mm256_loadu_ps(&_parent_h[i]);
+
+				_mm256_storeu_ps(&_x[i], _mm256_add_ps(_mm256_add_ps(px, _mm256_mul_ps(pw, _mm256_loadu_ps(&_pos_anchor_x[i]))), _mm256_loadu_ps(&_pos_offset_x[i])));
+				_mm256_storeu_ps(&_y[i], _mm256_add_ps(_mm256_add_ps(py, _mm256_mul_ps(ph, _mm256_loadu_ps(&_pos_anchor_y[i]))), _mm256_loadu_ps(&_pos_offset_y[i])));
+				_mm256_storeu_ps(&_w[i], _mm256_add_ps(_mm256_mul_ps(pw, _mm256_loadu_ps(&_size_anchor_x[i])), _mm256_loadu_ps(&_size_offset_x[i])));
+				_mm256_storeu_ps(&_h[i], _mm256_add_ps(_mm256_mul_ps(ph, _mm256_loadu_ps(&_size_anchor_y[i])), _mm256_loadu_ps(&_size_offset_y[i])));
+			}
+#endif
+#ifdef GUI_SIMD_SSE2
+			for (; i + 4 <= end; i += 4)
+			{
+				const __m128 px = _mm_loadu_ps(&_parent_x[i]);
+				const __m128 py = _mm_loadu_ps(&_parent_y[i]);
+				const __m128 pw = _mm_loadu_ps(&_parent_w[i]);
+				const __m128 ph = _mm_loadu_ps(&_parent_h[i]);
+
+				_mm_storeu_ps(&_x[i], _mm_add_ps(_mm_add_ps(px, _mm_mul_ps(pw, _mm_loadu_ps(&_pos_anchor_x[i]))), _mm_loadu_ps(&_pos_offset_x[i])));
+				_mm_storeu_ps(&_y[i], _mm_add_ps(_mm_add_ps(py, _mm_mul_ps(ph, _mm_loadu_ps(&_pos_anchor_y[i]))), _mm_loadu_ps(&_pos_offset_y[i])));
+				_mm_storeu_ps(&_w[i], _mm_add_ps(_mm_mul_ps(pw, _mm_loadu_ps(&_size_anchor_x[i])), _mm_loadu_ps(&_size_offset_x[i])));
+				_mm_storeu_ps(&_h[i], _mm_add_ps(_mm_mul_ps(ph, _mm_loadu_ps(&_size_anchor_y[i])), _mm_loadu_ps(&_size_offset_y[i])));
+			}
+#endif
+			for (; i < end; i++)
+			{
+				_x[i] = _parent_x[i] + _parent_w[i] * _pos_anchor_x[i] + _pos_offset_x[i];
+				_y[i] = _parent_y[i] + _parent_h[i] * _pos_anchor_y[i] + _pos_offset_y[i];
+				_w[i] = _parent_w[i] * _size_anchor_x[i] + _size_offset_x[i];
+				_h[i] = _parent_h[i] * _size_anchor_y[i] + _size_offset_y[i];
+			}
+		}
+	};
+
+	// Filled rects laid out in bulk through a LayoutStore, for decoration such as grids and charts
+	// with far more rects than are worth a container each. Rects are evaluated against the shape of
+	// the field and may lie outside it; the bounds used for culling and damage are the union of the
+	// rects as last evaluated. Rects are drawn parents first.
+	struct RectField : public IRenderable
+	{
+		typedef LayoutStore::Handle Handle;
+		static constexpr Handle npos = LayoutStore::npos;
+
+		SDL::Renderer& r;
+
+		inline RectField(int render_order, SDL::Renderer& r, const GUIRect& shape)
+			: IRenderable(shape, render_order), r(r) { _batched = true; }
+
+		// The parent must already be in the field, or npos for a rect within the field itself.
+		Handle Add(const GUIRect& shape, const SDL::Colour& colour, Handle parent = npos)
+		{
+			const Handle h = _store.Add(shape, parent);
+
+			if (_colours.size() <= h) _colours.resize(h + 1);
+			_colours[h] = colour;
+
+			InvalidateLayout();
+			Invalidate();
+			return h;
+		}
+
+		// Children must be removed first.
+		void Remove(Handle h)
+		{
+			_store.Remove(h);
+			InvalidateLayout();
+			Invalidate();
+		}
+
+		void SetShape(Handle h, const GUIRect& shape)
+		{
+			_store.Set(h, shape);
+			InvalidateLayout();
+			Invalidate();
+		}
+
+		void SetColour(Handle h, const SDL::Colour& colour)
+		{
+			_colours[h] = colour;
+			Invalidate();
+		}
+
+		inline const LayoutStore& Store() const { return _store; }
+
+		void _SetParentShape(const SDL::FRect& parent)
+		{
+			_shape = shape.Get(parent);
+			_store.Evaluate(_shape);
+
+			// Rects may be placed anywhere relative to the field, so only their union covers what is drawn
+			bool any = false;
+			float x0 = _shape.x, y0 = _shape.y, x1 = _shape.x, y1 = _shape.y;
+
+			_store.ForEach([&](Handle, const SDL::FRect& rect)
+			{
+				const float left = std::min(rect.x, rect.x + rect.w), right = std::max(rect.x, rect.x + rect.w);
+				const float top = std::min(rect.y, rect.y + rect.h), bottom = std::max(rect.y, rect.y + rect.h);
+
+				x0 = any ? std::min(x0, left) : left;
+				y0 = any ? std::min(y0, top) : top;
+				x1 = any ? std::max(x1, right) : right;
+				y1 = any ? std::max(y1, bottom) : bottom;
+				any = true;
+			});
+
+			SetBounds(SDL::FRect(x0, y0, x1 - x0, y1 - y0));
+		}
+
+		void RenderGUI()
+		{
+			_store.ForEach([this](Handle h, const SDL::FRect& rect) { RectBatch::Fill(r, _colours[h], rect); });
+		}
+
+	private:
+		LayoutStore _store;
+		std::vector<SDL::Colour> _colours;
+		SDL::FRect _shape;
+	};
+}
\ No newline at end of file
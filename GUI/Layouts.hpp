@@ -0,0 +1,393 @@
+#pragma once
+#include "GUIElements.hpp"
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+namespace GUI
+{
+	enum class Axis
+	{
+		HORIZONTAL,
+		VERTICAL
+	};
+
+	// A base for containers that place each child in a computed cell, which the child's own shape
+	// is then evaluated in. The size a child asks for is the absolute part of the size of its shape,
+	// and is cached until the child is invalidated. Cells are sized from what children ask for, so
+	// relative sizes are taken of the cell: a child that only asks relatively gets no length along
+	// a stack or flex axis unless grow factors share some out, though it does fill the cell across it.
+	// Layout restarts from the first child whose cell may have moved, unless the area of the
+	// container itself changed. Call InvalidateLayout on a child after changing its shape.
+	struct LayoutContainer : public ContainerGroup
+	{
+		// Space inside the edges of this container.
+		float padding = 0.f;
+		// Space between neighbouring cells.
+		float spacing = 0.f;
+
+		inline LayoutContainer(const GUIRect& shape, float spacing, float padding) : ContainerGroup(shape), padding(padding), spacing(spacing) {}
+
+		// Lays out every child from index on again. Call with 0 after changing members of a layout directly.
+		inline void InvalidateFrom(size_t index)
+		{
+			_dirty_from = std::min(_dirty_from, index);
+			InvalidateLayout();
+		}
+
+		// Size of the arranged cells including padding, as of the last layout.
+		inline SDL::FPoint GetContentSize() const { return _content_size; }
+
+	protected:
+		static constexpr size_t npos = ~(size_t)0;
+
+		// Area inside the padding, as of the last layout.
+		SDL::FRect _content = {};
+		SDL::FPoint _content_size = { 0.f, 0.f };
+		// The cached size each child asks for.
+		std::vector<SDL::FPoint> _intrinsic = {};
+		size_t _dirty_from = 0;
+
+		inline static SDL::FPoint _Measure(const IContainer& child) { return child.shape.size.offset; }
+
+		// Places the children from index from on, which is always a value returned by _AffectedFrom.
+		virtual void _Arrange(size_t from) = 0;
+
+		// The first child whose cell can move when the child at index changes.
+		virtual size_t _AffectedFrom(size_t index) const { return index; }
+
+		// Keep per child arrays of derived containers in step with the children.
+		virtual void _OnInserted(size_t index) {}
+		virtual void _OnRemoved(size_t index) {}
+
+		bool _AddChild(std::shared_ptr<IContainer> child)
+		{
+			return _InsertChild(_children.size(), child);
+		}
+
+		bool _InsertChild(size_t index, std::shared_ptr<IContainer> child)
+		{
+			ContainerGroup::_InsertChild(index, child);
+			_intrinsic.insert(std::next(_intrinsic.begin(), index), _Measure(*child));
+			_OnInserted(index);
+			_dirty_from = std::min(_dirty_from, index);
+			return true;
+		}
+
+		void _RemoveChild(size_t index)
+		{
+			ContainerGroup::_RemoveChild(index);
+			_intrinsic.erase(std::next(_intrinsic.begin(), index));
+			_OnRemoved(index);
+			InvalidateFrom(index);
+		}
+
+		// Cells follow the order of the children, so it is kept.
+		void _RemoveChildUnordered(size_t index)
+		{
+			_RemoveChild(index);
+		}
+
+		void _ClearChildren()
+		{
+			for (size_t i = _children.size(); i-- > 0;) _OnRemoved(i);
+
+			ContainerGroup::_ClearChildren();
+			_intrinsic.clear();
+			InvalidateFrom(0);
+		}
+
+		void _SetParentShape(const SDL::FRect& parent)
+		{
+			const SDL::FRect outer = shape.Get(parent);
+			const SDL::FRect content(outer.x + padding, outer.y + padding, outer.w - 2.f * padding, outer.h - 2.f * padding);
+
+			if (!(content == _content))
+			{
+				_content = content;
+				_dirty_from = 0;
+			}
+
+			_Relayout();
+		}
+
+		// Measures the children that were invalidated before relaying out.
+		void _RelayoutDirtyChildren()
+		{
+			for (size_t i = 0; i < _children.size(); i++)
+			{
+				if (!_children[i]->IsLayoutDirty()) continue;
+
+				const SDL::FPoint size = _Measure(*_children[i]);
+
+				if (!(size == _intrinsic[i]))
+				{
+					_intrinsic[i] = size;
+					_dirty_from = std::min(_dirty_from, i);
+				}
+			}
+
+			_Relayout();
+		}
+
+		void _Relayout()
+		{
+			const size_t n = _children.size();
+			const size_t from = _dirty_from < n ? _AffectedFrom(_dirty_from) : n;
+
+			_dirty_from = npos;
+
+			// Cells before the first change stay where they are
+			for (size_t i = 0; i < from; i++)
+			{
+				IContainer& child = *_children[i];
+				if (child.IsLayoutDirty()) child.SetParentShape(child.parent_shape);
+			}
+
+			if (from < n) _Arrange(from);
+			else if (n == 0) _content_size = { 2.f * padding, 2.f * padding };
+		}
+
+		inline SDL::FRect _Cell(Axis axis, float offset, float length) const
+		{
+			if (axis == Axis::VERTICAL) return SDL::FRect(_content.x, _content.y + offset, _content.w, length);
+			else return SDL::FRect(_content.x + offset, _content.y, length, _content.h);
+		}
+
+		inline static float _Main(Axis axis, const SDL::FPoint& p) { return axis == Axis::VERTICAL ? p.y : p.x; }
+		inline static float _Cross(Axis axis, const SDL::FPoint& p) { return axis == Axis::VERTICAL ? p.x : p.y; }
+
+		inline SDL::FPoint _Size(Axis axis, float main, float cross) const
+		{
+			main += 2.f * padding;
+			cross += 2.f * padding;
+			return axis == Axis::VERTICAL ? SDL::FPoint(cross, main) : SDL::FPoint(main, cross);
+		}
+	};
+
+	// Places children one after another along an axis. Each cell is as long as its child asks
+	// for and spans the stack across the axis. Inserting a child only moves the cells after it.
+	struct StackContainer : public LayoutContainer
+	{
+		// Call InvalidateFrom(0) after changing this directly.
+		Axis axis;
+
+		inline StackContainer(const GUIRect& shape, Axis axis = Axis::VERTICAL, float spacing = 0.f, float padding = 0.f)
+			: LayoutContainer(shape, spacing, padding), axis(axis) {}
+
+		inline ~StackContainer()
+		{
+			ClearChildren();
+		}
+
+	protected:
+		// Start of each cell along the axis, from the start of the content.
+		std::vector<float> _offsets = {};
+		// Size across the axis each child had when last arranged, or _uncounted before its first arrange.
+		std::vector<float> _crosses = {};
+		// The largest of _crosses and 0, and how many children have it, so arranging only looks at
+		// every child again once the last child with the largest size shrinks or is removed.
+		float _cross = 0.f;
+		size_t _cross_count = 0;
+		bool _cross_stale = false;
+
+		static constexpr float _uncounted = -std::numeric_limits<float>::infinity();
+
+		void _OnInserted(size_t index) { _crosses.insert(std::next(_crosses.begin(), index), _uncounted); }
+
+		void _OnRemoved(size_t index)
+		{
+			if (!_cross_stale && _crosses[index] == _cross && --_cross_count == 0) _cross_stale = true;
+			_crosses.erase(std::next(_crosses.begin(), index));
+		}
+
+		void _Arrange(size_t from)
+		{
+			const size_t n = _children.size();
+			_offsets.resize(n);
+
+			float pos = from == 0 ? 0.f : _offsets[from - 1] + _Main(axis, _intrinsic[from - 1]) + spacing;
+
+			for (size_t i = from; i < n; i++)
+			{
+				const float length = _Main(axis, _intrinsic[i]);
+
+				_offsets[i] = pos;
+				_children[i]->SetParentShape(_Cell(axis, pos, length));
+
+				_Count(i, _Cross(axis, _intrinsic[i]));
+
+				pos += length + spacing;
+			}
+
+			if (_cross_stale)
+			{
+				_cross = 0.f;
+				_cross_count = 0;
+				_cross_stale = false;
+
+				for (const float cross : _crosses) _Count(cross);
+			}
+
+			_content_size = _Size(axis, n == 0 ? 0.f : pos - spacing, _cross);
+		}
+
+		// Adds a cross size to the largest and its count.
+		inline void _Count(float cross)
+		{
+			if (cross > _cross)
+			{
+				_cross = cross;
+				_cross_count = 1;
+			}
+			else if (cross == _cross) _cross_count++;
+		}
+
+		// Replaces the cross size recorded for a child, leaving the largest stale when its last holder shrinks.
+		inline void _Count(size_t index, float cross)
+		{
+			const float old = _crosses[index];
+			_crosses[index] = cross;
+
+			if (_cross_stale) return;
+
+			const float largest = _cross;
+			_Count(cross);
+
+			if (old == largest && old == _cross && --_cross_count == 0) _cross_stale = true;
+		}
+	};
+
+	// Places children along an axis like a stack, then shares the length left over between children
+	// by their grow factors, or takes back a shortfall in proportion to the length of each child.
+	// Every child affects every cell, so any change lays out all children again.
+	struct FlexContainer : public LayoutContainer
+	{
+		// Call InvalidateFrom(0) after changing this directly.
+		Axis axis;
+
+		inline FlexContainer(const GUIRect& shape, Axis axis = Axis::HORIZONTAL, float spacing = 0.f, float padding = 0.f)
+			: LayoutContainer(shape, spacing, padding), axis(axis) {}
+
+		inline ~FlexContainer()
+		{
+			ClearChildren();
+		}
+
+		// Share of the left over length given to a child. Children start with 0.
+		inline void SetGrow(size_t index, float grow)
+		{
+			assert(index < _grow.size());
+			_grow[index] = grow;
+			InvalidateFrom(0);
+		}
+
+		inline float GetGrow(size_t index) const
+		{
+			assert(index < _grow.size());
+			return _grow[index];
+		}
+
+	protected:
+		std::vector<float> _grow = {};
+
+		size_t _AffectedFrom(size_t index) const { return 0; }
+
+		void _OnInserted(size_t index) { _grow.insert(std::next(_grow.begin(), index), 0.f); }
+		void _OnRemoved(size_t index) { _grow.erase(std::next(_grow.begin(), index)); }
+
+		void _Arrange(size_t from)
+		{
+			const size_t n = _children.size();
+
+			float total = 0.f;
+			float total_grow = 0.f;
+			float cross = 0.f;
+
+			for (size_t i = 0; i < n; i++)
+			{
+				total += _Main(axis, _intrinsic[i]);
+				total_grow += _grow[i];
+				cross = std::max(cross, _Cross(axis, _intrinsic[i]));
+			}
+
+			const float gaps = n == 0 ? 0.f : spacing * (n - 1);
+			const float free = _Main(axis, _content.size) - total - gaps;
+
+			float pos = 0.f;
+
+			for (size_t i = 0; i < n; i++)
+			{
+				const float basis = _Main(axis, _intrinsic[i]);
+				float length = basis;
+
+				if (free > 0.f && total_grow > 0.f) length += free * _grow[i] / total_grow;
+				else if (free < 0.f && total > 0.f) length = std::max(0.f, basis + free * basis / total);
+
+				_children[i]->SetParentShape(_Cell(axis, pos, length));
+
+				pos += length + spacing;
+			}
+
+			_content_size = _Size(axis, n == 0 ? 0.f : pos - spacing, cross);
+		}
+	};
+
+	// Places children in rows of equal width columns, filling each row before the next.
+	// Each row is as tall as the tallest child in it. Inserting a child only moves the rows from its own on.
+	struct GridContainer : public LayoutContainer
+	{
+		// Call InvalidateFrom(0) after changing this directly.
+		size_t columns;
+
+		inline GridContainer(const GUIRect& shape, size_t columns, float spacing = 0.f, float padding = 0.f)
+			: LayoutContainer(shape, spacing, padding), columns(std::max<size_t>(columns, 1)) {}
+
+		inline ~GridContainer()
+		{
+			ClearChildren();
+		}
+
+	protected:
+		// Top of each row, from the top of the content.
+		std::vector<float> _row_offsets = {};
+		std::vector<float> _row_heights = {};
+
+		size_t _AffectedFrom(size_t index) const { return index - index % columns; }
+
+		void _Arrange(size_t from)
+		{
+			const size_t n = _children.size();
+			const size_t rows = (n + columns - 1) / columns;
+			const float width = (_content.w - spacing * (columns - 1)) / columns;
+
+			_row_offsets.resize(rows);
+			_row_heights.resize(rows);
+
+			size_t row = from / columns;
+			float y = row == 0 ? 0.f : _row_offsets[row - 1] + _row_heights[row - 1] + spacing;
+
+			for (; row < rows; row++)
+			{
+				const size_t begin = row * columns;
+				const size_t end = std::min(begin + columns, n);
+
+				float height = 0.f;
+				for (size_t i = begin; i < end; i++) height = std::max(height, _intrinsic[i].y);
+
+				_row_offsets[row] = y;
+				_row_heights[row] = height;
+
+				for (size_t i = begin; i < end; i++)
+				{
+					const float x = (i - begin) * (width + spacing);
+					_children[i]->SetParentShape(SDL::FRect(_content.x + x, _content.y + y, width, height));
+				}
+
+				y += height + spacing;
+			}
+
+			_content_size = SDL::FPoint(_content.w + 2.f * padding, (rows == 0 ? 0.f : y - spacing) + 2.f * padding);
+		}
+	};
+}
\ No newline at end of file
@@ -1,6 +1,12 @@
+#pragma once
 #include <SDL.hpp>
+#include "Simd.hpp"
 #include <type_traits>
 #include <cassert>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <limits>
 
 inline constexpr SDL::Point Clamp(const SDL::Point& value, const SDL::Point& min, const SDL::Point& max)
 {
@@ -136,4 +142,382 @@ template<typename T1, typename T2>
 inline constexpr T2 MapRangeClamped(const T1& value, const T1& min_in, const T1& max_in, const T2& min_out, const T2& max_out)
 {
 	return Lerp(InverseLerpClamped(value, min_in, max_in), min_out, max_out);
+}
+
+// Bulk versions of the functions above, over arrays of count values.
+// Each result is identical to calling the scalar function on each value, including
+// rounding half away from zero on the integer paths. The clamped versions clamp t to [0,1].
+
+#if defined(GUI_SIMD_SSE2)
+// std::round of each lane: truncates, then steps away from zero when the remainder is at least a half.
+inline __m128 RoundHalfAway(__m128 x)
+{
+	const __m128 r = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	const __m128 f = _mm_sub_ps(x, r);
+	const __m128 one = _mm_set1_ps(1.f);
+
+	return _mm_sub_ps
+	(
+		_mm_add_ps(r, _mm_and_ps(_mm_cmpge_ps(f, _mm_set1_ps(.5f)), one)),
+		_mm_and_ps(_mm_cmple_ps(f, _mm_set1_ps(-.5f)), one)
+	);
+}
+
+inline __m128d RoundHalfAway(__m128d x)
+{
+	const __m128d r = _mm_cvtepi32_pd(_mm_cvttpd_epi32(x));
+	const __m128d f = _mm_sub_pd(x, r);
+	const __m128d one = _mm_set1_pd(1.0);
+
+	return _mm_sub_pd
+	(
+		_mm_add_pd(r, _mm_and_pd(_mm_cmpge_pd(f, _mm_set1_pd(.5)), one)),
+		_mm_and_pd(_mm_cmple_pd(f, _mm_set1_pd(-.5)), one)
+	);
+}
+
+// Operand order keeps NaN in t, like std::clamp.
+inline __m128 Clamp01(__m128 t) { return _mm_min_ps(_mm_set1_ps(1.f), _mm_max_ps(_mm_setzero_ps(), t)); }
+inline __m128d Clamp01(__m128d t) { return _mm_min_pd(_mm_set1_pd(1.0), _mm_max_pd(_mm_setzero_pd(), t)); }
+#endif
+
+#if defined(GUI_SIMD_AVX)
+inline __m256 RoundHalfAway(__m256 x)
+{
+	const __m256 r = _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+	const __m256 f = _mm256_sub_ps(x, r);
+	const __m256 one = _mm256_set1_ps(1.f);
+
+	return _mm256_sub_ps
+	(
+		_mm256_add_ps(r, _mm256_and_ps(_mm256_cmp_ps(f, _mm256_set1_ps(.5f), _CMP_GE_OQ), one)),
+		_mm256_and_ps(_mm256_cmp_ps(f, _mm256_set1_ps(-.5f), _CMP_LE_OQ), one)
+	);
+}
+
+inline __m256d RoundHalfAway(__m256d x)
+{
+	const __m256d r = _mm256_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+	const __m256d f = _mm256_sub_pd(x, r);
+	const __m256d one = _mm256_set1_pd(1.0);
+
+	return _mm256_sub_pd
+	(
+		_mm256_add_pd(r, _mm256_and_pd(_mm256_cmp_pd(f, _mm256_set1_pd(.5), _CMP_GE_OQ), one)),
+		_mm256_and_pd(_mm256_cmp_pd(f, _mm256_set1_pd(-.5), _CMP_LE_OQ), one)
+	);
+}
+
+inline __m256 Clamp01(__m256 t) { return _mm256_min_ps(_mm256_set1_ps(1.f), _mm256_max_ps(_mm256_setzero_ps(), t)); }
+inline __m256d Clamp01(__m256d t) { return _mm256_min_pd(_mm256_set1_pd(1.0), _mm256_max_pd(_mm256_setzero_pd(), t)); }
+#endif
+
+// out[i] = min + range * t[i], with t clamped if asked.
+template<bool clamped>
+inline void LerpAffine(const float* t, float* out, size_t count, float min, float range)
+{
+	size_t i = 0;
+
+#if defined(GUI_SIMD_AVX)
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_set1_ps(min), _mm256_mul_ps(_mm256_set1_ps(range), v)));
+	}
+#endif
+#if defined(GUI_SIMD_SSE2)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 v = _mm_loadu_ps(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_set1_ps(min), _mm_mul_ps(_mm_set1_ps(range), v)));
+	}
+#endif
+
+	for (; i < count; i++) out[i] = min + range * (clamped ? std::clamp(t[i], 0.f, 1.f) : t[i]);
+}
+
+template<bool clamped>
+inline void LerpAffine(const double* t, double* out, size_t count, double min, double range)
+{
+	size_t i = 0;
+
+#if defined(GUI_SIMD_AVX)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m256d v = _mm256_loadu_pd(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_set1_pd(min), _mm256_mul_pd(_mm256_set1_pd(range), v)));
+	}
+#endif
+#if defined(GUI_SIMD_SSE2)
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d v = _mm_loadu_pd(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		_mm_storeu_pd(out + i, _mm_add_pd(_mm_set1_pd(min), _mm_mul_pd(_mm_set1_pd(range), v)));
+	}
+#endif
+
+	for (; i < count; i++) out[i] = min + range * (clamped ? std::clamp(t[i], 0.0, 1.0) : t[i]);
+}
+
+// out[i] = round(min + range * t[i]), with t clamped if asked.
+template<bool clamped>
+inline void LerpAffine(const float* t, int* out, size_t count, float min, float range)
+{
+	size_t i = 0;
+
+#if defined(GUI_SIMD_AVX)
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		v = RoundHalfAway(_mm256_add_ps(_mm256_set1_ps(min), _mm256_mul_ps(_mm256_set1_ps(range), v)));
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_cvttps_epi32(v));
+	}
+#endif
+#if defined(GUI_SIMD_SSE2)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 v = _mm_loadu_ps(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		v = RoundHalfAway(_mm_add_ps(_mm_set1_ps(min), _mm_mul_ps(_mm_set1_ps(range), v)));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_cvttps_epi32(v));
+	}
+#endif
+
+	for (; i < count; i++) out[i] = (int)std::round(min + range * (clamped ? std::clamp(t[i], 0.f, 1.f) : t[i]));
+}
+
+template<bool clamped>
+inline void LerpAffine(const double* t, int* out, size_t count, double min, double range)
+{
+	size_t i = 0;
+
+#if defined(GUI_SIMD_AVX)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m256d v = _mm256_loadu_pd(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		v = RoundHalfAway(_mm256_add_pd(_mm256_set1_pd(min), _mm256_mul_pd(_mm256_set1_pd(range), v)));
+		_mm_storeu_si128((__m128i*)(out + i), _mm256_cvttpd_epi32(v));
+	}
+#endif
+#if defined(GUI_SIMD_SSE2)
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d v = _mm_loadu_pd(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		v = RoundHalfAway(_mm_add_pd(_mm_set1_pd(min), _mm_mul_pd(_mm_set1_pd(range), v)));
+		_mm_storel_epi64((__m128i*)(out + i), _mm_cvttpd_epi32(v));
+	}
+#endif
+
+	for (; i < count; i++) out[i] = (int)std::round(min + range * (clamped ? std::clamp(t[i], 0.0, 1.0) : t[i]));
+}
+
+inline void Lerp(const float* t, float* out, size_t count, float min, float max) { LerpAffine<false>(t, out, count, min, max - min); }
+inline void Lerp(const double* t, double* out, size_t count, double min, double max) { LerpAffine<false>(t, out, count, min, max - min); }
+inline void Lerp(const float* t, int* out, size_t count, int min, int max) { LerpAffine<false>(t, out, count, (float)min, (float)(max - min)); }
+inline void Lerp(const double* t, int* out, size_t count, int min, int max) { LerpAffine<false>(t, out, count, (double)min, (double)(max - min)); }
+
+inline void LerpClamped(const float* t, float* out, size_t count, float min, float max) { LerpAffine<true>(t, out, count, min, max - min); }
+inline void LerpClamped(const double* t, double* out, size_t count, double min, double max) { LerpAffine<true>(t, out, count, min, max - min); }
+inline void LerpClamped(const float* t, int* out, size_t count, int min, int max) { LerpAffine<true>(t, out, count, (float)min, (float)max - (float)min); }
+inline void LerpClamped(const double* t, int* out, size_t count, int min, int max) { LerpAffine<true>(t, out, count, (double)min, (double)max - (double)min); }
+
+// Points are interleaved x, y in memory, so each t is applied to two neighbouring floats.
+template<bool clamped>
+inline void LerpAffine(const float* t, SDL::FPoint* out, size_t count, const SDL::FPoint& min, const SDL::FPoint& range)
+{
+	size_t i = 0;
+
+#if defined(GUI_SIMD_SSE2)
+	const __m128 m = _mm_setr_ps(min.x, min.y, min.x, min.y);
+	const __m128 r = _mm_setr_ps(range.x, range.y, range.x, range.y);
+	float* o = reinterpret_cast<float*>(out);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 v = _mm_loadu_ps(t + i);
+		if constexpr (clamped) v = Clamp01(v);
+		_mm_storeu_ps(o + 2 * i, _mm_add_ps(m, _mm_mul_ps(r, _mm_unpacklo_ps(v, v))));
+		_mm_storeu_ps(o + 2 * i + 4, _mm_add_ps(m, _mm_mul_ps(r, _mm_unpackhi_ps(v, v))));
+	}
+#endif
+
+	for (; i < count; i++) out[i] = min + range * (clamped ? std::clamp(t[i], 0.f, 1.f) : t[i]);
+}
+
+inline void Lerp(const float* t, SDL::FPoint* out, size_t count, const SDL::FPoint& min, const SDL::FPoint& max) { LerpAffine<false>(t, out, count, min, max - min); }
+inline void LerpClamped(const float* t, SDL::FPoint* out, size_t count, const SDL::FPoint& min, const SDL::FPoint& max) { LerpAffine<true>(t, out, count, min, max - min); }
+
+// out[i] = (value[i] - min) / range, with the result clamped if asked.
+template<bool clamped>
+inline void InverseLerpAffine(const float* value, float* out, size_t count, float min, float range)
+{
+	size_t i = 0;
+
+#if defined(GUI_SIMD_AVX)
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 v = _mm256_div_ps(_mm256_sub_ps(_mm256_loadu_ps(value + i), _mm256_set1_ps(min)), _mm256_set1_ps(range));
+		if constexpr (clamped) v = Clamp01(v);
+		_mm256_storeu_ps(out + i, v);
+	}
+#endif
+#if defined(GUI_SIMD_SSE2)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 v = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(value + i), _mm_set1_ps(min)), _mm_set1_ps(range));
+		if constexpr (clamped) v = Clamp01(v);
+		_mm_storeu_ps(out + i, v);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const float v = (value[i] - min) / range;
+		out[i] = clamped ? std::clamp(v, 0.f, 1.f) : v;
+	}
+}
+
+template<bool clamped>
+inline void InverseLerpAffine(const double* value, double* out, size_t count, double min, double range)
+{
+	size_t i = 0;
+
+#if defined(GUI_SIMD_AVX)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m256d v = _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(value + i), _mm256_set1_pd(min)), _mm256_set1_pd(range));
+		if constexpr (clamped) v = Clamp01(v);
+		_mm256_storeu_pd(out + i, v);
+	}
+#endif
+#if defined(GUI_SIMD_SSE2)
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d v = _mm_div_pd(_mm_sub_pd(_mm_loadu_pd(value + i), _mm_set1_pd(min)), _mm_set1_pd(range));
+		if constexpr (clamped) v = Clamp01(v);
+		_mm_storeu_pd(out + i, v);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const double v = (value[i] - min) / range;
+		out[i] = clamped ? std::clamp(v, 0.0, 1.0) : v;
+	}
+}
+
+// The difference is taken in integers, as the scalar template does.
+template<bool clamped>
+inline void InverseLerpAffine(const int* value, double* out, size_t count, int min, double range)
+{
+	size_t i = 0;
+
+#if defined(GUI_SIMD_AVX)
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i d = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(value + i)), _mm_set1_epi32(min));
+		__m256d v = _mm256_div_pd(_mm256_cvtepi32_pd(d), _mm256_set1_pd(range));
+		if constexpr (clamped) v = Clamp01(v);
+		_mm256_storeu_pd(out + i, v);
+	}
+#endif
+#if defined(GUI_SIMD_SSE2)
+	for (; i + 2 <= count; i += 2)
+	{
+		const __m128i d = _mm_sub_epi32(_mm_loadl_epi64((const __m128i*)(value + i)), _mm_set1_epi32(min));
+		__m128d v = _mm_div_pd(_mm_cvtepi32_pd(d), _mm_set1_pd(range));
+		if constexpr (clamped) v = Clamp01(v);
+		_mm_storeu_pd(out + i, v);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const double v = (value[i] - min) / range;
+		out[i] = clamped ? std::clamp(v, 0.0, 1.0) : v;
+	}
+}
+
+inline void InverseLerp(const float* value, float* out, size_t count, float min, float max) { InverseLerpAffine<false>(value, out, count, min, max - min); }
+inline void InverseLerp(const double* value, double* out, size_t count, double min, double max) { InverseLerpAffine<false>(value, out, count, min, max - min); }
+inline void InverseLerp(const int* value, double* out, size_t count, int min, int max) { InverseLerpAffine<false>(value, out, count, min, (double)(max - min)); }
+
+inline void InverseLerpClamped(const float* value, float* out, size_t count, float min, float max) { InverseLerpAffine<true>(value, out, count, min, max - min); }
+inline void InverseLerpClamped(const double* value, double* out, size_t count, double min, double max) { InverseLerpAffine<true>(value, out, count, min, max - min); }
+inline void InverseLerpClamped(const int* value, double* out, size_t count, int min, int max) { InverseLerpAffine<true>(value, out, count, min, (double)(max - min)); }
+
+// Projects interleaved points onto the line from min to max.
+template<bool clamped>
+inline void InverseLerpAffine(const SDL::FPoint* value, double* out, size_t count, const SDL::FPoint& min, const SDL::FPoint& max)
+{
+	const SDL::FPoint diff = max - min;
+	const float len = diff.mag();
+	const SDL::FPoint dir = diff / len;
+
+	size_t i = 0;
+
+#if defined(GUI_SIMD_SSE2)
+	const float* v = reinterpret_cast<const float*>(value);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 a = _mm_loadu_ps(v + 2 * i);
+		const __m128 b = _mm_loadu_ps(v + 2 * i + 4);
+		const __m128 x = _mm_div_ps(_mm_sub_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_set1_ps(min.x)), _mm_set1_ps(len));
+		const __m128 y = _mm_div_ps(_mm_sub_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), _mm_set1_ps(min.y)), _mm_set1_ps(len));
+
+		__m128 t = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(dir.x)), _mm_mul_ps(y, _mm_set1_ps(dir.y)));
+		if constexpr (clamped) t = Clamp01(t);
+
+		_mm_storeu_pd(out + i, _mm_cvtps_pd(t));
+		_mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(t, t)));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const float t = SDL::FPoint::dot((value[i] - min) / len, dir);
+		out[i] = clamped ? std::clamp(t, 0.f, 1.f) : t;
+	}
+}
+
+inline void InverseLerp(const SDL::FPoint* value, double* out, size_t count, const SDL::FPoint& min, const SDL::FPoint& max) { InverseLerpAffine<false>(value, out, count, min, max); }
+inline void InverseLerpClamped(const SDL::FPoint* value, double* out, size_t count, const SDL::FPoint& min, const SDL::FPoint& max) { InverseLerpAffine<true>(value, out, count, min, max); }
+
+// Maps in blocks through a small buffer of t, so both passes stay in cache.
+template<typename T1, typename T2>
+inline void MapRange(const T1* value, T2* out, size_t count, const T1& min_in, const T1& max_in, const T2& min_out, const T2& max_out)
+{
+	typedef decltype(InverseLerp(*value, min_in, max_in)) T;
+	T t[256];
+
+	for (size_t i = 0; i < count; i += 256)
+	{
+		const size_t n = std::min<size_t>(256, count - i);
+
+		InverseLerp(value + i, t, n, min_in, max_in);
+		Lerp((const T*)t, out + i, n, min_out, max_out);
+	}
+}
+
+template<typename T1, typename T2>
+inline void MapRangeClamped(const T1* value, T2* out, size_t count, const T1& min_in, const T1& max_in, const T2& min_out, const T2& max_out)
+{
+	typedef decltype(InverseLerpClamped(*value, min_in, max_in)) T;
+	T t[256];
+
+	for (size_t i = 0; i < count; i += 256)
+	{
+		const size_t n = std::min<size_t>(256, count - i);
+
+		InverseLerpClamped(value + i, t, n, min_in, max_in);
+		Lerp((const T*)t, out + i, n, min_out, max_out);
+	}
 }
\ No newline at end of file
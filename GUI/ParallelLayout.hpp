@@ -0,0 +1,215 @@
+#pragma once
+#include "GUI.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GUI
+{
+	// Lays out trees on a pool of threads. Subtrees of at least threshold containers, as counted by the
+	// last layout, are queued by the thread that reached them, and idle threads steal queued subtrees
+	// from busy ones. Each container is laid out exactly as in a serial pass, so the resulting shapes
+	// are identical; changes to shared state, such as Damage and HitGrid, are serialised by LayoutLock.
+	// Layout never renders, so the renderer is not touched by the pool.
+	// A queued child is only laid out by the time its parent's SetParentShape returns, so containers
+	// must not read the layout of their children within _SetParentShape, but in _OnSubtreeLaidOut.
+	struct ParallelLayout : public LayoutScheduler
+	{
+		// Smallest subtree handed to the pool. Smaller subtrees are laid out by the thread that reached them.
+		size_t threshold = 256;
+
+		// Uses the calling thread and threads - 1 workers.
+		inline ParallelLayout(unsigned threads = std::thread::hardware_concurrency())
+		{
+			threads = std::max(threads, 1u);
+
+			for (unsigned i = 0; i < threads; i++) _queues.push_back(std::make_unique<Queue>());
+			for (unsigned i = 1; i < threads; i++) _threads.emplace_back(&ParallelLayout::_Work, this, i);
+		}
+
+		inline ~ParallelLayout()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_state_mutex);
+				_stop = true;
+			}
+
+			_wake.notify_all();
+
+			for (std::thread& t : _threads) t.join();
+		}
+
+		ParallelLayout(const ParallelLayout&) = delete;
+		ParallelLayout& operator=(const ParallelLayout&) = delete;
+
+		inline size_t NumThreads() const { return _queues.size(); }
+
+		// Lays out a tree as root.SetParentShape(parent) would. Call with the root of the tree, from the
+		// thread that owns the GUI, and not from within another layout.
+		inline void Run(IContainer& root, const SDL::FRect& parent)
+		{
+			if (_threads.empty())
+			{
+				root.SetParentShape(parent);
+				return;
+			}
+
+			LayoutLock::active = true;
+			_SetScheduler(this);
+			_current = this;
+			_worker = 0;
+
+			{
+				std::lock_guard<std::mutex> lock(_state_mutex);
+				_running = true;
+			}
+
+			_wake.notify_all();
+
+			Join join;
+			Begin(join);
+			root.SetParentShape(parent);
+			End(join);
+
+			{
+				std::lock_guard<std::mutex> lock(_state_mutex);
+				_running = false;
+			}
+
+			_current = nullptr;
+			_SetScheduler(nullptr);
+			LayoutLock::active = false;
+
+			Damage::AddDeferred();
+			_GrowAncestors(root);
+		}
+
+		bool Defer(IContainer& c, const SDL::FRect& parent)
+		{
+			if (_current != this || c.SubtreeSize() < threshold) return false;
+
+			_join->pending.fetch_add(1, std::memory_order_relaxed);
+
+			Queue& q = *_queues[_worker];
+			std::lock_guard<std::mutex> lock(q.mutex);
+			q.tasks.push_back({ &c, parent, _join });
+
+			return true;
+		}
+
+		void Begin(Join& join)
+		{
+			join.outer = _join;
+			_join = &join;
+		}
+
+		void End(Join& join)
+		{
+			while (join.pending.load(std::memory_order_acquire) != 0)
+			{
+				if (!_RunOne()) std::this_thread::yield();
+			}
+
+			_join = join.outer;
+		}
+
+	private:
+		struct Task
+		{
+			IContainer* container;
+			SDL::FRect parent;
+			Join* join;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> _queues = {};
+		std::vector<std::thread> _threads = {};
+
+		std::mutex _state_mutex;
+		std::condition_variable _wake;
+		std::atomic<bool> _running = false;
+		bool _stop = false;
+
+		// The pool and queue of the current thread, and the join of the container it is laying out.
+		inline static thread_local ParallelLayout* _current = nullptr;
+		inline static thread_local size_t _worker = 0;
+		inline static thread_local Join* _join = nullptr;
+
+		// Runs the newest task of this thread, or else the oldest task of another.
+		// Returns false if there was nothing to run.
+		inline bool _RunOne()
+		{
+			Task task;
+
+			if (!_Pop(task) && !_Steal(task)) return false;
+
+			_LayoutNow(*task.container, task.parent);
+			task.join->pending.fetch_sub(1, std::memory_order_release);
+
+			return true;
+		}
+
+		inline bool _Pop(Task& task)
+		{
+			Queue& q = *_queues[_worker];
+			std::lock_guard<std::mutex> lock(q.mutex);
+
+			if (q.tasks.empty()) return false;
+
+			task = q.tasks.back();
+			q.tasks.pop_back();
+			return true;
+		}
+
+		// Oldest tasks are nearest the root, so a steal takes as much work as possible.
+		inline bool _Steal(Task& task)
+		{
+			const size_t n = _queues.size();
+
+			for (size_t i = 1; i < n; i++)
+			{
+				Queue& q = *_queues[(_worker + i) % n];
+				std::lock_guard<std::mutex> lock(q.mutex);
+
+				if (q.tasks.empty()) continue;
+
+				task = q.tasks.front();
+				q.tasks.pop_front();
+				return true;
+			}
+
+			return false;
+		}
+
+		inline void _Work(size_t index)
+		{
+			_current = this;
+			_worker = index;
+
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(_state_mutex);
+					_wake.wait(lock, [this] { return _stop || _running; });
+
+					if (_stop) return;
+				}
+
+				// Spins while the pass lasts, so no subtree waits on a thread waking up
+				while (_running.load(std::memory_order_acquire))
+				{
+					if (!_RunOne()) std::this_thread::yield();
+				}
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,407 @@
+#pragma once
+#include "GUI.hpp"
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+namespace GUI
+{
+	// A uniform grid of the interactive areas of GUI elements in screen coordinates.
+	// Finds the topmost element under the pointer by testing only the areas binned in one cell.
+	struct HitGrid
+	{
+		typedef uint32_t Handle;
+		static constexpr Handle npos = ~(Handle)0;
+
+		// Width and height of a cell in pixels.
+		static constexpr float cell_size = 64.f;
+		// Areas spanning more cells than this are kept in a list tested on every query.
+		static constexpr int max_cells = 64;
+
+		inline static Handle Add(IContainer& owner, int order)
+		{
+			LayoutLock lock;
+			Handle h;
+
+			if (_free.empty())
+			{
+				h = (Handle)_entries.size();
+				_entries.emplace_back();
+			}
+			else
+			{
+				h = _free.back();
+				_free.pop_back();
+			}
+
+			Entry& e = _entries[h];
+			e = Entry();
+			e.owner = &owner;
+			e.order = order;
+			e.seq = _seq++;
+
+			return h;
+		}
+
+		inline static void Remove(Handle h)
+		{
+			LayoutLock lock;
+
+			assert(h < _entries.size() && _entries[h].owner != nullptr);
+
+			_Unbin(h);
+			_entries[h].owner = nullptr;
+			_free.push_back(h);
+		}
+
+		// Moves an area, rebinning it only if it crossed into other cells.
+		inline static void Set(Handle h, const SDL::FRect& area)
+		{
+			LayoutLock lock;
+
+			assert(h < _entries.size() && _entries[h].owner != nullptr);
+
+			Entry& e = _entries[h];
+			e.area = area;
+
+			int x0, y0, x1, y1;
+			const bool binned = area.w > 0 && area.h > 0;
+
+			if (binned)
+			{
+				x0 = _Cell(area.x);
+				y0 = _Cell(area.y);
+				x1 = _Cell(area.x + area.w);
+				y1 = _Cell(area.y + area.h);
+
+				if (e.binned && x0 == e.x0 && y0 == e.y0 && x1 == e.x1 && y1 == e.y1) return;
+			}
+
+			_Unbin(h);
+
+			if (!binned) return;
+
+			e.binned = true;
+			e.x0 = x0;
+			e.y0 = y0;
+			e.x1 = x1;
+			e.y1 = y1;
+
+			if ((int64_t)(x1 - x0 + 1) * (y1 - y0 + 1) > max_cells)
+			{
+				_large.push_back(h);
+				return;
+			}
+
+			for (int y = y0; y <= y1; y++)
+			{
+				for (int x = x0; x <= x1; x++)
+				{
+					_cells[_Key(x, y)].push_back(h);
+				}
+			}
+		}
+
+		// Areas with a higher order are on top; within an order, later areas are on top,
+		// matching the paint order of IRenderable.
+		inline static void SetOrder(Handle h, int order)
+		{
+			LayoutLock lock;
+
+			assert(h < _entries.size() && _entries[h].owner != nullptr);
+
+			_entries[h].order = order;
+			_entries[h].seq = _seq++;
+		}
+
+		// The owner of the topmost area containing the point, or nullptr.
+		inline static IContainer* Query(const SDL::Point& point)
+		{
+			const Entry* top = nullptr;
+
+			auto test = [&top, &point](Handle h)
+			{
+				const Entry& e = _entries[h];
+
+				if (!e.area.contains(point) || e.owner->IsHidden() || !e.owner->HitClipContains(point)) return;
+
+				if (top == nullptr || e.order > top->order || (e.order == top->order && e.seq > top->seq))
+				{
+					top = &e;
+				}
+			};
+
+			auto it = _cells.find(_Key(_Cell((float)point.x), _Cell((float)point.y)));
+
+			if (it != _cells.end())
+			{
+				for (Handle h : it->second) test(h);
+			}
+
+			for (Handle h : _large) test(h);
+
+			return top == nullptr ? nullptr : top->owner;
+		}
+
+	private:
+		struct Entry
+		{
+			IContainer* owner = nullptr;
+			SDL::FRect area = {};
+			int order = 0;
+			uint64_t seq = 0;
+			bool binned = false;
+			int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+		};
+
+		inline static std::vector<Entry> _entries = {};
+		inline static std::vector<Handle> _free = {};
+		inline static std::unordered_map<uint64_t, std::vector<Handle>> _cells = {};
+		inline static std::vector<Handle> _large = {};
+		inline static uint64_t _seq = 0;
+
+		inline static int _Cell(float v) { return (int)std::floor(v / cell_size); }
+		inline static uint64_t _Key(int x, int y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+		inline static void _Erase(std::vector<Handle>& v, Handle h)
+		{
+			auto it = std::find(v.begin(), v.end(), h);
+			assert(it != v.end());
+			*it = v.back();
+			v.pop_back();
+		}
+
+		inline static void _Unbin(Handle h)
+		{
+			Entry& e = _entries[h];
+
+			if (!e.binned) return;
+			e.binned = false;
+
+			if ((int64_t)(e.x1 - e.x0 + 1) * (e.y1 - e.y0 + 1) > max_cells)
+			{
+				_Erase(_large, h);
+				return;
+			}
+
+			for (int y = e.y0; y <= e.y1; y++)
+			{
+				for (int x = e.x0; x <= e.x1; x++)
+				{
+					auto it = _cells.find(_Key(x, y));
+					assert(it != _cells.end());
+
+					_Erase(it->second, h);
+					if (it->second.empty()) _cells.erase(it);
+				}
+			}
+		}
+	};
+
+	// Subscribes to mouse events once and routes each one to a single element: the element
+	// holding pointer capture if there is one, otherwise the topmost element under the pointer.
+	// Events the element does not handle bubble up its chain of parents.
+	// Consecutive motion events for the same element are merged into one, sent by Flush or before the
+	// next event for another element, so a drag costs one update per frame however fast the mouse reports.
+	struct PointerRouter
+	{
+		// When disabled, every motion event is sent as soon as it is received.
+		inline static bool coalesce_motion = true;
+
+		// Call after SDL::Input::Init.
+		inline static void Init()
+		{
+			SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEBUTTONDOWN, _down_observer);
+			SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEBUTTONUP, _up_observer);
+			SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEMOTION, _motion_observer);
+			SDL::Input::RegisterEventType(SDL::Event::Type::MOUSEWHEEL, _wheel_observer);
+		}
+
+		// Call before SDL::Input::Quit.
+		inline static void Quit()
+		{
+			SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEBUTTONDOWN, _down_observer);
+			SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEBUTTONUP, _up_observer);
+			SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEMOTION, _motion_observer);
+			SDL::Input::UnregisterEventType(SDL::Event::Type::MOUSEWHEEL, _wheel_observer);
+
+			_DropPending();
+		}
+
+		// Routes all pointer events to an element until it releases capture, such as during a drag.
+		inline static void SetCapture(IContainer& c) { _capture = &c; }
+
+		inline static void ReleaseCapture(IContainer& c)
+		{
+			if (_capture == &c) _capture = nullptr;
+		}
+
+		inline static IContainer* GetCapture() { return _capture; }
+
+		// Drops any reference to an element that is going away.
+		inline static void Forget(IContainer& c)
+		{
+			LayoutLock lock;
+			ReleaseCapture(c);
+
+			if (_pending_target == &c) _DropPending();
+		}
+
+		// Sends the motion merged since the last flush. Call once per frame, after SDL::Input::Update.
+		inline static void Flush()
+		{
+			if (!_has_pending) return;
+
+			IContainer* target = _pending_target;
+			const SDL::Event event = _pending_event;
+
+			// Kept aside, so a handler may start merging motion again
+			std::vector<SDL::Point> history;
+			history.swap(_history);
+
+			PointerEvent e = { PointerEvent::Type::MOTION, _pending_position, 0, event };
+			if (_history_users != 0) e.history = &history;
+
+			_DropPending();
+			_DispatchTo(target, e);
+
+			history.clear();
+			if (_history.empty()) _history.swap(history);
+		}
+
+		// Records the position of each motion event merged, for elements that follow the exact path of
+		// the pointer, such as for drawing. Counted, so each call needs a matching DropHistory.
+		inline static void KeepHistory() { _history_users++; }
+		inline static void DropHistory()
+		{
+			assert(_history_users != 0);
+			_history_users--;
+		}
+
+	private:
+		template <PointerEvent::Type type>
+		struct Observer : SDL::InputObserver
+		{
+			void Notify(const SDL::Event& e)
+			{
+				if constexpr (type == PointerEvent::Type::MOTION)
+				{
+					PointerRouter::_Merge(e);
+					return;
+				}
+
+				// Motion before this event reaches its target first
+				PointerRouter::Flush();
+
+				if constexpr (type == PointerEvent::Type::WHEEL)
+				{
+					// Wheel events carry no position, so they go to whatever is under the pointer now
+					SDL::Point position;
+					SDL_GetMouseState(&position.x, &position.y);
+
+					PointerRouter::_Dispatch({ type, position, 0, e });
+				}
+				else
+				{
+					PointerRouter::_Dispatch({ type, { e.button.x, e.button.y }, e.button.button, e });
+				}
+			}
+		};
+
+		inline static Observer<PointerEvent::Type::DOWN> _down_observer;
+		inline static Observer<PointerEvent::Type::UP> _up_observer;
+		inline static Observer<PointerEvent::Type::MOTION> _motion_observer;
+		inline static Observer<PointerEvent::Type::WHEEL> _wheel_observer;
+		inline static IContainer* _capture = nullptr;
+
+		// Motion received but not yet sent, and the element it goes to.
+		inline static bool _has_pending = false;
+		inline static IContainer* _pending_target = nullptr;
+		inline static SDL::Point _pending_position = { 0, 0 };
+		inline static SDL::Event _pending_event = {};
+		inline static std::vector<SDL::Point> _history = {};
+		inline static size_t _history_users = 0;
+
+		inline static IContainer* _Target(const SDL::Point& position)
+		{
+			return _capture != nullptr ? _capture : HitGrid::Query(position);
+		}
+
+		inline static void _Merge(const SDL::Event& e)
+		{
+			const SDL::Point position = { e.motion.x, e.motion.y };
+
+			if (!coalesce_motion)
+			{
+				_Dispatch({ PointerEvent::Type::MOTION, position, 0, e });
+				return;
+			}
+
+			IContainer* target = _Target(position);
+
+			if (_has_pending && target != _pending_target) Flush();
+
+			if (_has_pending)
+			{
+				const Sint32 xrel = _pending_event.motion.xrel;
+				const Sint32 yrel = _pending_event.motion.yrel;
+
+				_pending_event = e;
+				_pending_event.motion.xrel += xrel;
+				_pending_event.motion.yrel += yrel;
+			}
+			else _pending_event = e;
+
+			_has_pending = true;
+			_pending_target = target;
+			_pending_position = position;
+
+			if (_history_users != 0) _history.push_back(position);
+		}
+
+		inline static void _DropPending()
+		{
+			_has_pending = false;
+			_pending_target = nullptr;
+			_history.clear();
+		}
+
+		inline static void _Dispatch(const PointerEvent& e)
+		{
+			_DispatchTo(_Target(e.position), e);
+		}
+
+		inline static void _DispatchTo(IContainer* target, const PointerEvent& e)
+		{
+			if (target != nullptr) Stats::CountInputEvent();
+
+			for (IContainer* c = target; c != nullptr; c = c->parent)
+			{
+				if (c->OnPointerEvent(e)) return;
+			}
+		}
+	};
+
+	// The interactive area of an element, registered with HitGrid and PointerRouter for the
+	// lifetime of the element. Keep it up to date from _SetParentShape.
+	struct HitRegion
+	{
+		inline HitRegion(IContainer& owner, int order = 0) : _owner(owner), _handle(HitGrid::Add(owner, order)) {}
+		inline ~HitRegion()
+		{
+			HitGrid::Remove(_handle);
+			PointerRouter::Forget(_owner);
+		}
+
+		HitRegion(const HitRegion&) = delete;
+		HitRegion& operator=(const HitRegion&) = delete;
+
+		inline void Set(const SDL::FRect& area) { HitGrid::Set(_handle, area); }
+		inline void SetOrder(int order) { HitGrid::SetOrder(_handle, order); }
+
+	private:
+		IContainer& _owner;
+		HitGrid::Handle _handle;
+	};
+}
\ No newline at end of file
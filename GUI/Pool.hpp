@@ -0,0 +1,121 @@
+#pragma once
+#include "Sync.hpp"
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace GUI
+{
+	// Fixed size blocks carved out of large pages, with freed blocks kept on a free list.
+	// There is one pool for each block size and alignment, shared by every type of that size.
+	template <size_t Size, size_t Align>
+	struct BlockPool
+	{
+		static constexpr size_t align = Align < alignof(void*) ? alignof(void*) : Align;
+		static constexpr size_t block_size = ((Size < sizeof(void*) ? sizeof(void*) : Size) + align - 1) / align * align;
+		static constexpr size_t page_size = 64 * 1024;
+		static constexpr size_t blocks_per_page = block_size < page_size / 16 ? page_size / block_size : 16;
+
+		inline static void* Allocate()
+		{
+			LayoutLock lock;
+
+			if (_free == nullptr) _AddPage();
+
+			Block* b = _free;
+			_free = b->next;
+			_live++;
+
+			return b;
+		}
+
+		inline static void Free(void* p)
+		{
+			LayoutLock lock;
+
+			assert(_live > 0);
+
+			Block* b = static_cast<Block*>(p);
+			b->next = _free;
+			_free = b;
+			_live--;
+		}
+
+		// Blocks currently handed out.
+		inline static size_t Live() { return _live; }
+		// Pages allocated, each holding blocks_per_page blocks.
+		inline static size_t Pages() { return _pages.size(); }
+
+		// Returns every page to the system if no blocks are in use.
+		inline static void Trim()
+		{
+			if (_live != 0) return;
+
+			_pages.clear();
+			_free = nullptr;
+		}
+
+	private:
+		struct Block { Block* next; };
+
+		struct PageDeleter
+		{
+			void operator()(void* p) const { ::operator delete(p, std::align_val_t(align)); }
+		};
+
+		inline static std::vector<std::unique_ptr<void, PageDeleter>> _pages = {};
+		inline static Block* _free = nullptr;
+		inline static size_t _live = 0;
+
+		// Threads the blocks of a new page onto the free list in address order,
+		// so consecutive allocations sit next to each other.
+		inline static void _AddPage()
+		{
+			char* page = static_cast<char*>(::operator new(block_size * blocks_per_page, std::align_val_t(align)));
+			_pages.emplace_back(page);
+
+			for (size_t i = blocks_per_page; i--;)
+			{
+				Block* b = reinterpret_cast<Block*>(page + i * block_size);
+				b->next = _free;
+				_free = b;
+			}
+		}
+	};
+
+	// Allocates single objects from the BlockPool of their size.
+	// Arrays fall back to the global allocator.
+	template <typename T>
+	struct PoolAllocator
+	{
+		typedef T value_type;
+
+		PoolAllocator() noexcept = default;
+		template <typename U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+		inline T* allocate(size_t n)
+		{
+			if (n == 1) return static_cast<T*>(BlockPool<sizeof(T), alignof(T)>::Allocate());
+			return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+		}
+
+		inline void deallocate(T* p, size_t n) noexcept
+		{
+			if (n == 1) BlockPool<sizeof(T), alignof(T)>::Free(p);
+			else ::operator delete(p, std::align_val_t(alignof(T)));
+		}
+
+		template <typename U> bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+		template <typename U> bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+	};
+
+	// Creates a GUI element in pooled memory. The object and its reference count share one block.
+	template <typename T, typename... Args>
+	inline std::shared_ptr<T> Make(Args&&... args)
+	{
+		return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+	}
+}
\ No newline at end of file
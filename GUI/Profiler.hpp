@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Define GUI_PROFILE to record how long each part of a frame takes. Without it the GUI_PROFILE macros
+// expand to nothing and the library records no timings at all.
+// GUI_PROFILE_CAPACITY sets the number of timings kept, which must be a power of two.
+#ifndef GUI_PROFILE_CAPACITY
+#define GUI_PROFILE_CAPACITY (1 << 16)
+#endif
+
+namespace GUI
+{
+	// Scoped timers written to a ring buffer shared by every thread, which keeps the most recent timings
+	// and can be written out as a Chrome trace, for chrome://tracing or Perfetto. Timings on the same
+	// thread nest by time, so the trace shows each scope within the scopes that contain it.
+	// Recording a timing takes two clock reads and a fetch_add, and never locks or allocates.
+	struct Profiler
+	{
+		static constexpr size_t capacity = GUI_PROFILE_CAPACITY;
+		static_assert((capacity & (capacity - 1)) == 0, "GUI_PROFILE_CAPACITY must be a power of two");
+
+		// Names must outlive the profiler, as only the pointer is stored.
+		struct Event
+		{
+			const char* name;
+			// Name of the value attached to the timing, or nullptr if it has none.
+			const char* arg_name;
+			int64_t arg;
+			uint64_t begin;
+			uint64_t duration;
+			uint64_t frame;
+			uint32_t thread;
+		};
+
+		// Times the enclosing scope. Restart ends the current timing and begins another, for
+		// timing consecutive parts of a loop with one object.
+		struct Scope
+		{
+			inline Scope() : _name(nullptr) {}
+			inline Scope(const char* name, const char* arg_name = nullptr, int64_t arg = 0)
+			{
+				_Begin(name, arg_name, arg);
+			}
+
+			inline ~Scope() { _End(); }
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+			inline void Restart(const char* name, const char* arg_name = nullptr, int64_t arg = 0)
+			{
+				_End();
+				_Begin(name, arg_name, arg);
+			}
+
+		private:
+			const char* _name;
+			const char* _arg_name = nullptr;
+			int64_t _arg = 0;
+			uint64_t _begin = 0;
+
+			inline void _Begin(const char* name, const char* arg_name, int64_t arg)
+			{
+				_name = enabled ? name : nullptr;
+				if (_name == nullptr) return;
+
+				_arg_name = arg_name;
+				_arg = arg;
+				_begin = Now();
+			}
+
+			inline void _End()
+			{
+				if (_name != nullptr) Record(_name, _begin, Now(), _arg_name, _arg);
+				_name = nullptr;
+			}
+		};
+
+		// Recording can be paused at runtime, without rebuilding.
+		inline static bool enabled = true;
+
+		// Smallest subtree whose layout is timed on its own, besides the root of each pass. Timing every
+		// container would fill the buffer within one layout of a large tree.
+		inline static size_t min_layout_subtree = 256;
+
+		// Nanoseconds since an arbitrary point, on the clock used for every timing.
+		inline static uint64_t Now()
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		// Starts the next frame. Timings are tagged with the frame they were recorded in.
+		inline static void NextFrame()
+		{
+			Record("Frame", Now(), 0, nullptr, 0);
+			_frame.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		inline static uint64_t GetFrame() { return _frame.load(std::memory_order_relaxed); }
+
+		// Adds a timing, overwriting the oldest once the buffer is full. An end of 0 records an instant.
+		inline static void Record(const char* name, uint64_t begin, uint64_t end, const char* arg_name, int64_t arg)
+		{
+			const uint64_t index = _next.fetch_add(1, std::memory_order_relaxed);
+			Slot& slot = _slots[index & (capacity - 1)];
+
+			// Marked unwritten first, so a reader never takes a timing that is half overwritten
+			slot.written.store(0, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			slot.event = { name, arg_name, arg, begin, end == 0 ? 0 : end - begin, GetFrame(), _ThreadId() };
+
+			slot.written.store(index + 1, std::memory_order_release);
+		}
+
+		// Copies out the timings still in the buffer, oldest first.
+		// Call between frames, when no other thread is recording.
+		inline static std::vector<Event> Events()
+		{
+			std::vector<Event> events;
+
+			const uint64_t end = _next.load(std::memory_order_acquire);
+			const uint64_t begin = end > capacity ? end - capacity : 0;
+
+			events.reserve((size_t)(end - begin));
+
+			for (uint64_t i = begin; i < end; i++)
+			{
+				const Slot& slot = _slots[i & (capacity - 1)];
+				if (slot.written.load(std::memory_order_acquire) == i + 1) events.push_back(slot.event);
+			}
+
+			return events;
+		}
+
+		// Empties the buffer. Call between frames, when no other thread is recording.
+		inline static void Clear()
+		{
+			for (Slot& slot : _slots) slot.written.store(0, std::memory_order_relaxed);
+			_next.store(0, std::memory_order_release);
+		}
+
+		// Writes the buffer as Chrome trace event JSON. Returns false if the file could not be written.
+		inline static bool WriteTrace(FILE* f)
+		{
+			const std::vector<Event> events = Events();
+
+			// Events are kept in the order they ended, so the oldest beginning can be anywhere
+			uint64_t origin = ~(uint64_t)0;
+			for (const Event& e : events) origin = std::min(origin, e.begin);
+
+			std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+			for (size_t i = 0; i < events.size(); i++)
+			{
+				const Event& e = events[i];
+
+				// Timestamps are microseconds in the format, relative to the oldest timing to keep precision
+				const double ts = (double)(e.begin - origin) / 1000.0;
+
+				std::fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"gui\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,", i == 0 ? "" : ",", e.name, e.thread, ts);
+
+				if (e.duration == 0) std::fprintf(f, "\"ph\":\"i\",\"s\":\"p\",");
+				else std::fprintf(f, "\"ph\":\"X\",\"dur\":%.3f,", (double)e.duration / 1000.0);
+
+				std::fprintf(f, "\"args\":{\"frame\":%llu", (unsigned long long)e.frame);
+				if (e.arg_name != nullptr) std::fprintf(f, ",\"%s\":%lld", e.arg_name, (long long)e.arg);
+				std::fprintf(f, "}}");
+			}
+
+			std::fprintf(f, "\n]}\n");
+
+			return std::ferror(f) == 0;
+		}
+
+		inline static bool WriteTrace(const char* path)
+		{
+			FILE* f = std::fopen(path, "w");
+			if (f == nullptr) return false;
+
+			const bool ok = WriteTrace(f);
+			return std::fclose(f) == 0 && ok;
+		}
+
+	private:
+		struct Slot
+		{
+			// Index of the timing held plus one, or 0 while it is being written.
+			std::atomic<uint64_t> written;
+			Event event;
+		};
+
+		// Zeroed as static storage, so no slot starts out written.
+		inline static Slot _slots[capacity];
+		inline static std::atomic<uint64_t> _next = 0;
+		inline static std::atomic<uint64_t> _frame = 0;
+		inline static std::atomic<uint32_t> _threads = 0;
+
+		// Small numbers are easier to read in a trace than native thread ids.
+		inline static uint32_t _ThreadId()
+		{
+			static thread_local const uint32_t id = _threads.fetch_add(1, std::memory_order_relaxed);
+			return id;
+		}
+	};
+}
+
+#define GUI_PROFILE_JOIN2(a, b) a##b
+#define GUI_PROFILE_JOIN(a, b) GUI_PROFILE_JOIN2(a, b)
+
+#ifdef GUI_PROFILE
+// Times the rest of the enclosing scope under a name, optionally with a named value such as a count.
+#define GUI_PROFILE_SCOPE(...) GUI::Profiler::Scope GUI_PROFILE_JOIN(_gui_profile_, __LINE__)(__VA_ARGS__)
+// Marks the start of a frame.
+#define GUI_PROFILE_FRAME() GUI::Profiler::NextFrame()
+#else
+#define GUI_PROFILE_SCOPE(...) ((void)0)
+#define GUI_PROFILE_FRAME() ((void)0)
+#endif
\ No newline at end of file
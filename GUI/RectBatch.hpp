@@ -0,0 +1,135 @@
+#pragma once
+#include <SDL.hpp>
+#include <vector>
+
+namespace GUI
+{
+	// Collects rects drawn by GUI elements into runs with the same renderer, colour and kind,
+	// and submits each run with a single FillRectsF or DrawRectsF call.
+	// Only consecutive submissions are merged, and runs are drawn in the order they were started,
+	// so the paint order is unchanged. IRenderable flushes between render orders and before elements
+	// that draw to the renderer themselves.
+	struct RectBatch
+	{
+		struct Stats
+		{
+			// Rects submitted through the batch.
+			size_t rects;
+			// Renderer draw calls actually made for them.
+			size_t draw_calls;
+			// Draw calls made in a different colour from the one before.
+			size_t colour_changes;
+
+			inline constexpr size_t Saved() const { return rects - draw_calls; }
+		};
+
+		// When disabled, rects are drawn as soon as they are submitted.
+		inline static bool enabled = true;
+
+		inline static void Fill(SDL::Renderer& r, const SDL::Colour& colour, const SDL::FRect& rect)
+		{
+			_Submit(r, colour, rect, Kind::FILL);
+		}
+
+		inline static void Outline(SDL::Renderer& r, const SDL::Colour& colour, const SDL::FRect& rect)
+		{
+			_Submit(r, colour, rect, Kind::OUTLINE);
+		}
+
+		// Draws the pending runs. Call this before drawing to a renderer without the batch.
+		inline static void Flush()
+		{
+			if (_num_runs == 0) return;
+
+			for (size_t i = 0; i < _num_runs; i++) _Draw(_runs[i]);
+
+			_num_runs = 0;
+		}
+
+		// Counts since the last call to ResetStats.
+		inline static const Stats& GetStats() { return _stats; }
+		inline static void ResetStats() { _stats = Stats(); }
+
+	private:
+		enum class Kind { FILL, OUTLINE };
+
+		struct Run
+		{
+			SDL::Renderer* renderer;
+			SDL::Colour colour;
+			Kind kind;
+			std::vector<SDL::FRect> rects;
+		};
+
+		// Pending runs in submission order are the first _num_runs, and the rest keep their storage for reuse.
+		inline static std::vector<Run> _runs = {};
+		inline static size_t _num_runs = 0;
+		// Runs queued before they are drawn without waiting for a flush, which bounds the storage kept.
+		static constexpr size_t _max_runs = 64;
+
+		inline static Stats _stats = Stats();
+		inline static SDL::Colour _last_drawn;
+
+		inline static constexpr bool _SameColour(const SDL::Colour& a, const SDL::Colour& b)
+		{
+			return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+		}
+
+		inline static void _CountDraw(const SDL::Colour& colour)
+		{
+			if (_stats.draw_calls == 0 || !_SameColour(colour, _last_drawn)) _stats.colour_changes++;
+
+			_last_drawn = colour;
+			_stats.draw_calls++;
+		}
+
+		inline static void _Submit(SDL::Renderer& r, const SDL::Colour& colour, const SDL::FRect& rect, Kind kind)
+		{
+			_stats.rects++;
+
+			if (!enabled)
+			{
+				r.SetDrawColour(colour);
+
+				if (kind == Kind::FILL) r.FillRectF(rect);
+				else                    r.DrawRectF(rect);
+
+				_CountDraw(colour);
+				return;
+			}
+
+			if (_num_runs != 0 && _Matches(_runs[_num_runs - 1], r, colour, kind))
+			{
+				_runs[_num_runs - 1].rects.push_back(rect);
+				return;
+			}
+
+			if (_num_runs == _max_runs) Flush();
+			if (_num_runs == _runs.size()) _runs.emplace_back();
+
+			Run& run = _runs[_num_runs];
+			run.renderer = &r;
+			run.colour = colour;
+			run.kind = kind;
+			run.rects.clear();
+			run.rects.push_back(rect);
+
+			_num_runs++;
+		}
+
+		inline static bool _Matches(const Run& run, const SDL::Renderer& r, const SDL::Colour& colour, Kind kind)
+		{
+			return run.renderer == &r && run.kind == kind && _SameColour(run.colour, colour);
+		}
+
+		inline static void _Draw(const Run& run)
+		{
+			run.renderer->SetDrawColour(run.colour);
+
+			if (run.kind == Kind::FILL) run.renderer->FillRectsF(run.rects);
+			else                        run.renderer->DrawRectsF(run.rects);
+
+			_CountDraw(run.colour);
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,205 @@
+#pragma once
+#include "Sync.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <assert.h>
+
+namespace GUI
+{
+	// A flat registry of objects grouped into buckets iterated by ascending order.
+	// Each object keeps a Handle to its slot, so adding and removing are O(1) and changing order
+	// is a remove plus an add. Buckets are contiguous arrays iterated in registration order;
+	// removed slots are left empty and compacted before a later iteration.
+	template <typename T>
+	struct OrderedRegistry
+	{
+		static constexpr uint32_t npos = ~(uint32_t)0;
+
+		struct Handle
+		{
+			uint32_t bucket = npos;
+			uint32_t slot = npos;
+
+			inline constexpr bool IsRegistered() const { return slot != npos; }
+		};
+
+		void Add(T& item, Handle& handle, int order)
+		{
+			LayoutLock lock;
+
+			assert(!handle.IsRegistered());
+
+			const uint32_t b = _FindOrAddBucket(order);
+			Bucket& bucket = _buckets[b];
+
+			handle.bucket = b;
+			handle.slot = (uint32_t)bucket.items.size();
+
+			bucket.items.push_back(&item);
+			bucket.handles.push_back(&handle);
+			_size++;
+		}
+
+		void Remove(Handle& handle)
+		{
+			LayoutLock lock;
+
+			if (!handle.IsRegistered()) return;
+
+			Bucket& bucket = _buckets[handle.bucket];
+
+			assert(bucket.handles[handle.slot] == &handle);
+
+			bucket.items[handle.slot] = nullptr;
+			bucket.handles[handle.slot] = nullptr;
+			bucket.holes++;
+			_size--;
+
+			handle = Handle();
+		}
+
+		void SetOrder(Handle& handle, int order)
+		{
+			LayoutLock lock;
+
+			if (!handle.IsRegistered()) return;
+			if (_buckets[handle.bucket].order == order) return;
+
+			T& item = *_buckets[handle.bucket].items[handle.slot];
+
+			Remove(handle);
+			Add(item, handle, order);
+		}
+
+		inline size_t Size() const { return _size; }
+
+		// Calls f on every registered object, by ascending order and then registration order.
+		// Objects may be added or removed by f; objects added during iteration may be skipped,
+		// and always are when their order had no bucket before the iteration began.
+		template <typename F>
+		void ForEach(F&& f)
+		{
+			_BeginIteration();
+
+			for (size_t i = 0; i < _sorted.size(); i++)
+			{
+				const uint32_t b = _sorted[i];
+
+				for (size_t j = 0; j < _buckets[b].items.size(); j++)
+				{
+					T* item = _buckets[b].items[j];
+					if (item != nullptr) f(*item);
+				}
+			}
+
+			_EndIteration();
+		}
+
+		// As ForEach, also calling begin with the order of each bucket before its objects.
+		template <typename F, typename B>
+		void ForEach(F&& f, B&& begin)
+		{
+			_BeginIteration();
+
+			for (size_t i = 0; i < _sorted.size(); i++)
+			{
+				const uint32_t b = _sorted[i];
+
+				if (_buckets[b].items.size() == _buckets[b].holes) continue;
+
+				begin(_buckets[b].order);
+
+				for (size_t j = 0; j < _buckets[b].items.size(); j++)
+				{
+					T* item = _buckets[b].items[j];
+					if (item != nullptr) f(*item);
+				}
+			}
+
+			_EndIteration();
+		}
+
+	private:
+		struct Bucket
+		{
+			int order;
+			std::vector<T*> items = {};
+			std::vector<Handle*> handles = {};
+			size_t holes = 0;
+
+			inline Bucket(int order) : order(order) {}
+		};
+
+		// Indices into _buckets are stable, _sorted holds them by ascending order.
+		std::vector<Bucket> _buckets = {};
+		std::vector<uint32_t> _sorted = {};
+		// Buckets added during iteration, kept out of _sorted until it ends so no bucket is skipped or repeated.
+		std::vector<uint32_t> _pending = {};
+		size_t _size = 0;
+		int _iterating = 0;
+
+		inline void _BeginIteration()
+		{
+			if (_iterating++ == 0) _Compact();
+		}
+
+		inline void _EndIteration()
+		{
+			if (--_iterating != 0) return;
+
+			for (uint32_t b : _pending) _sorted.insert(_LowerBound(_buckets[b].order), b);
+			_pending.clear();
+		}
+
+		inline std::vector<uint32_t>::iterator _LowerBound(int order)
+		{
+			return std::lower_bound(_sorted.begin(), _sorted.end(), order, [this](uint32_t b, int o)
+			{
+				return _buckets[b].order < o;
+			});
+		}
+
+		uint32_t _FindOrAddBucket(int order)
+		{
+			auto it = _LowerBound(order);
+
+			if (it != _sorted.end() && _buckets[*it].order == order) return *it;
+
+			for (uint32_t b : _pending) if (_buckets[b].order == order) return b;
+
+			const uint32_t b = (uint32_t)_buckets.size();
+			_buckets.emplace_back(order);
+
+			if (_iterating != 0) _pending.push_back(b);
+			else                 _sorted.insert(it, b);
+
+			return b;
+		}
+
+		// Squeezes out removed slots of buckets where at least a quarter of the slots are empty.
+		void _Compact()
+		{
+			for (Bucket& bucket : _buckets)
+			{
+				if (bucket.holes == 0 || bucket.holes * 4 < bucket.items.size()) continue;
+
+				size_t out = 0;
+
+				for (size_t i = 0; i < bucket.items.size(); i++)
+				{
+					if (bucket.items[i] == nullptr) continue;
+
+					bucket.items[out] = bucket.items[i];
+					bucket.handles[out] = bucket.handles[i];
+					bucket.handles[out]->slot = (uint32_t)out;
+					out++;
+				}
+
+				bucket.items.resize(out);
+				bucket.handles.resize(out);
+				bucket.holes = 0;
+			}
+		}
+	};
+}
\ No newline at end of file
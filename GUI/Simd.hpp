@@ -0,0 +1,16 @@
+#pragma once
+
+// Selects the widest instruction set the compiler targets for the bulk kernels.
+// Define GUI_NO_SIMD to force the scalar fallbacks.
+#ifndef GUI_NO_SIMD
+#if defined(__AVX__)
+#define GUI_SIMD_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GUI_SIMD_SSE2
+#endif
+#endif // GUI_NO_SIMD
+
+#if defined(GUI_SIMD_AVX) || defined(GUI_SIMD_SSE2)
+#include <immintrin.h>
+#endif
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+#include <SDL.hpp>
+#include "RectBatch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace GUI
+{
+	// The work done in one frame, between Stats::BeginFrame and Stats::EndFrame.
+	struct FrameStats
+	{
+		// Draw calls made by RectBatch, plus one for each element that drew to the renderer itself.
+		size_t draw_calls = 0;
+		// RectBatch draw calls in a different colour from the call before.
+		size_t colour_changes = 0;
+		// Rects submitted to RectBatch.
+		size_t rects = 0;
+
+		// Elements rendered, skipped by culling, and skipped because they were disabled.
+		size_t rendered = 0;
+		size_t culled = 0;
+		size_t disabled = 0;
+
+		// Containers whose own layout was computed again, not counting clean ones passed through.
+		size_t laid_out = 0;
+		// Pointer events routed to an element.
+		size_t input_events = 0;
+
+		// Time from BeginFrame to EndFrame, in milliseconds.
+		double frame_ms = 0.0;
+	};
+
+	// Frame times over the last Stats::history frames, in milliseconds.
+	struct FrameTimes
+	{
+		size_t frames = 0;
+		double p50 = 0.0;
+		double p90 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	// Counters of the work the GUI does each frame, kept in every build and switched on at runtime.
+	// While disabled, each counted event costs a single branch. Call BeginFrame once the loop wakes and
+	// EndFrame once the frame is drawn, then read the totals with Last, or draw them with DrawOverlay.
+	struct Stats
+	{
+		// Number of frames that frame time percentiles are taken over.
+		inline static size_t history = 240;
+
+		inline static bool IsEnabled() { return _enabled; }
+
+		inline static void SetEnable(bool enable)
+		{
+			if (_enabled == enable) return;
+
+			_enabled = enable;
+			_times.clear();
+			_next_time = 0;
+			_last = FrameStats();
+
+			// Enabled part way through a frame, which is then counted from here
+			BeginFrame();
+		}
+
+		inline static void BeginFrame()
+		{
+			if (!_enabled) return;
+
+			_current = FrameStats();
+			_laid_out.store(0, std::memory_order_relaxed);
+			_batch = RectBatch::GetStats();
+			_begin = std::chrono::steady_clock::now();
+		}
+
+		inline static void EndFrame()
+		{
+			if (!_enabled) return;
+
+			const RectBatch::Stats& batch = RectBatch::GetStats();
+
+			_current.draw_calls += batch.draw_calls - std::min(_batch.draw_calls, batch.draw_calls);
+			_current.colour_changes = batch.colour_changes - std::min(_batch.colour_changes, batch.colour_changes);
+			_current.rects = batch.rects - std::min(_batch.rects, batch.rects);
+			_current.laid_out = _laid_out.load(std::memory_order_relaxed);
+			_current.frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _begin).count();
+
+			_last = _current;
+
+			if (_times.size() < history) _times.push_back(_current.frame_ms);
+			else if (!_times.empty()) _times[_next_time++ % _times.size()] = _current.frame_ms;
+		}
+
+		// The totals of the last frame ended.
+		inline static const FrameStats& Last() { return _last; }
+
+		inline static FrameTimes Times()
+		{
+			FrameTimes t;
+			t.frames = _times.size();
+
+			if (_times.empty()) return t;
+
+			std::vector<double> sorted = _times;
+			std::sort(sorted.begin(), sorted.end());
+
+			auto at = [&sorted](double p) { return sorted[(size_t)(p * (sorted.size() - 1) + .5)]; };
+
+			t.p50 = at(.5);
+			t.p90 = at(.9);
+			t.p99 = at(.99);
+			t.max = sorted.back();
+
+			return t;
+		}
+
+		// Draws the last frame's totals and frame times over whatever is on the renderer, through
+		// RectBatch, with the top left at pos. Each pixel of the font is scale pixels across.
+		inline static void DrawOverlay(SDL::Renderer& r, const SDL::FPoint& pos, float scale = 2.f)
+		{
+			const FrameStats& s = _last;
+			const FrameTimes t = Times();
+
+			char lines[5][64];
+			std::snprintf(lines[0], sizeof(lines[0]), "FRAME %.2f MS", s.frame_ms);
+			std::snprintf(lines[1], sizeof(lines[1]), "P50 %.2f P90 %.2f P99 %.2f", t.p50, t.p90, t.p99);
+			std::snprintf(lines[2], sizeof(lines[2]), "DRAWS %zu COLOURS %zu RECTS %zu", s.draw_calls, s.colour_changes, s.rects);
+			std::snprintf(lines[3], sizeof(lines[3]), "RENDER %zu CULL %zu OFF %zu", s.rendered, s.culled, s.disabled);
+			std::snprintf(lines[4], sizeof(lines[4]), "LAYOUT %zu INPUT %zu", s.laid_out, s.input_events);
+
+			size_t width = 0;
+			for (const char* line : lines) width = std::max(width, std::strlen(line));
+
+			// Glyphs are 3 by 5 with a pixel between them
+			const float pad = 2.f * scale;
+			const SDL::FRect back(pos.x, pos.y, (width * 4.f - 1.f) * scale + 2.f * pad, (5 * 6.f - 1.f) * scale + 2.f * pad);
+
+			RectBatch::Fill(r, SDL::Colour(0, 0, 0, 255), back);
+
+			for (size_t i = 0; i < 5; i++)
+			{
+				_DrawText(r, lines[i], SDL::FPoint(pos.x + pad, pos.y + pad + i * 6.f * scale), scale, SDL::Colour(255, 255, 255, 255));
+			}
+
+			RectBatch::Flush();
+		}
+
+		// Called by the library as it works. Do nothing while disabled.
+		inline static void CountRendered(bool batched)
+		{
+			if (!_enabled) return;
+
+			_current.rendered++;
+			if (!batched) _current.draw_calls++;
+		}
+
+		inline static void CountCulled() { if (_enabled) _current.culled++; }
+		inline static void CountDisabled() { if (_enabled) _current.disabled++; }
+		inline static void CountInputEvent() { if (_enabled) _current.input_events++; }
+
+		// Safe to call from layout threads.
+		inline static void CountLaidOut() { if (_enabled) _laid_out.fetch_add(1, std::memory_order_relaxed); }
+
+	private:
+		inline static bool _enabled = false;
+
+		inline static FrameStats _current = FrameStats();
+		inline static FrameStats _last = FrameStats();
+		inline static std::atomic<size_t> _laid_out = 0;
+		inline static RectBatch::Stats _batch = RectBatch::Stats();
+		inline static std::chrono::steady_clock::time_point _begin = {};
+
+		// Frame times of the last history frames, overwritten oldest first once full.
+		inline static std::vector<double> _times = {};
+		inline static size_t _next_time = 0;
+
+		// Rows of a 3 by 5 glyph, top first, with the leftmost pixel in the highest of the 3 bits.
+		inline static constexpr uint16_t _Glyph(char c)
+		{
+			switch (c)
+			{
+			case '0': return 0b111'101'101'101'111;
+			case '1': return 0b010'110'010'010'111;
+			case '2': return 0b111'001'111'100'111;
+			case '3': return 0b111'001'111'001'111;
+			case '4': return 0b101'101'111'001'001;
+			case '5': return 0b111'100'111'001'111;
+			case '6': return 0b111'100'111'101'111;
+			case '7': return 0b111'001'001'001'001;
+			case '8': return 0b111'101'111'101'111;
+			case '9': return 0b111'101'111'001'111;
+			case 'A': return 0b010'101'111'101'101;
+			case 'C': return 0b011'100'100'100'011;
+			case 'D': return 0b110'101'101'101'110;
+			case 'E': return 0b111'100'110'100'111;
+			case 'F': return 0b111'100'110'100'100;
+			case 'I': return 0b111'010'010'010'111;
+			case 'L': return 0b100'100'100'100'111;
+			case 'M': return 0b101'111'111'101'101;
+			case 'N': return 0b110'101'101'101'101;
+			case 'O': return 0b010'101'101'101'010;
+			case 'P': return 0b110'101'110'100'100;
+			case 'R': return 0b110'101'110'101'101;
+			case 'S': return 0b011'100'010'001'110;
+			case 'T': return 0b111'010'010'010'010;
+			case 'U': return 0b101'101'101'101'111;
+			case 'W': return 0b101'101'111'111'101;
+			case 'Y': return 0b101'101'010'010'010;
+			case '.': return 0b000'000'000'000'010;
+			default:  return 0;
+			}
+		}
+
+		inline static void _DrawText(SDL::Renderer& r, const char* text, const SDL::FPoint& pos, float scale, const SDL::Colour& colour)
+		{
+			float x = pos.x;
+
+			for (const char* c = text; *c != '\0'; c++, x += 4.f * scale)
+			{
+				const uint16_t glyph = _Glyph(*c);
+
+				for (int bit = 0; bit < 15; bit++)
+				{
+					if ((glyph >> (14 - bit) & 1) == 0) continue;
+
+					RectBatch::Fill(r, colour, SDL::FRect(x + (bit % 3) * scale, pos.y + (bit / 3) * scale, scale, scale));
+				}
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <mutex>
+
+namespace GUI
+{
+	// Serialises changes to state shared by the whole GUI, such as Damage, HitGrid and the registries,
+	// while ParallelLayout runs layout on several threads. Outside of a parallel pass it does nothing.
+	struct LayoutLock
+	{
+		// Set by ParallelLayout for the duration of a pass.
+		inline static bool active = false;
+
+		inline LayoutLock() : _locked(active)
+		{
+			if (_locked) _mutex.lock();
+		}
+
+		inline ~LayoutLock()
+		{
+			if (_locked) _mutex.unlock();
+		}
+
+		LayoutLock(const LayoutLock&) = delete;
+		LayoutLock& operator=(const LayoutLock&) = delete;
+
+	private:
+		bool _locked;
+
+		// Shared state can change again from within a change, such as a cached element damaging its group.
+		inline static std::recursive_mutex _mutex;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,297 @@
+#pragma once
+#include "GUI.hpp"
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+namespace GUI
+{
+	// Curves mapping linear progress in [0,1] to eased progress.
+	enum class Ease : uint8_t
+	{
+		LINEAR,
+		IN_QUAD,
+		OUT_QUAD,
+		IN_OUT_QUAD,
+		IN_CUBIC,
+		OUT_CUBIC,
+		IN_OUT_CUBIC,
+		SMOOTHSTEP
+	};
+
+	inline constexpr float Eased(Ease ease, float t)
+	{
+		switch (ease)
+		{
+		case Ease::IN_QUAD:      return t * t;
+		case Ease::OUT_QUAD:     return t * (2.f - t);
+		case Ease::IN_OUT_QUAD:  return t < .5f ? 2.f * t * t : -1.f + (4.f - 2.f * t) * t;
+		case Ease::IN_CUBIC:     return t * t * t;
+		case Ease::OUT_CUBIC:    { const float u = t - 1.f; return u * u * u + 1.f; }
+		case Ease::IN_OUT_CUBIC: { const float u = 2.f * t - 2.f; return t < .5f ? 4.f * t * t * t : .5f * u * u * u + 1.f; }
+		case Ease::SMOOTHSTEP:   return t * t * (3.f - 2.f * t);
+		default:                 return t;
+		}
+	}
+
+	// Runs every transition of GUI values in one pass per frame. Each tween moves a target value
+	// from where it was when the tween started to an end value, and tells the owner of the value
+	// that it changed. Tweens are stored as parallel arrays of up to four float channels.
+	// A target has at most one tween; starting another replaces it, starting from the current value.
+	// Call Stop on a target before it is destroyed.
+	struct Tweens
+	{
+		inline static void To(GUIPosition& target, const GUIPosition& to, Uint64 duration, Ease ease = Ease::LINEAR, IContainer* owner = nullptr)
+		{
+			const float from[4] = { target.anchor.x, target.anchor.y, target.offset.x, target.offset.y };
+			const float end[4] = { to.anchor.x, to.anchor.y, to.offset.x, to.offset.y };
+
+			_Start(Kind::POSITION, &target, from, end, duration, ease, owner, nullptr);
+		}
+
+		inline static void To(GUISize& target, const GUISize& to, Uint64 duration, Ease ease = Ease::LINEAR, IContainer* owner = nullptr)
+		{
+			const float from[4] = { target.anchor.x, target.anchor.y, target.offset.x, target.offset.y };
+			const float end[4] = { to.anchor.x, to.anchor.y, to.offset.x, to.offset.y };
+
+			_Start(Kind::SIZE, &target, from, end, duration, ease, owner, nullptr);
+		}
+
+		inline static void To(SDL::Colour& target, const SDL::Colour& to, Uint64 duration, Ease ease = Ease::LINEAR, IRenderable* owner = nullptr)
+		{
+			const float from[4] = { (float)target.r, (float)target.g, (float)target.b, (float)target.a };
+			const float end[4] = { (float)to.r, (float)to.g, (float)to.b, (float)to.a };
+
+			_Start(Kind::COLOUR, &target, from, end, duration, ease, nullptr, owner);
+		}
+
+		inline static void To(float& target, float to, Uint64 duration, Ease ease = Ease::LINEAR, IContainer* layout_owner = nullptr, IRenderable* render_owner = nullptr)
+		{
+			const float from[4] = { target, 0.f, 0.f, 0.f };
+			const float end[4] = { to, 0.f, 0.f, 0.f };
+
+			_Start(Kind::FLOAT, &target, from, end, duration, ease, layout_owner, render_owner);
+		}
+
+		// Leaves the target at its current value.
+		inline static void Stop(const void* target)
+		{
+			LayoutLock lock;
+
+			auto it = _index.find(target);
+			if (it == _index.end()) return;
+
+			_Erase(it->second);
+		}
+
+		inline static bool IsRunning(const void* target) { return _index.find(target) != _index.end(); }
+
+		// Milliseconds since the tween on the target started, or 0 if it has none.
+		inline static Uint64 Elapsed(const void* target)
+		{
+			auto it = _index.find(target);
+			return it == _index.end() ? 0 : (Uint64)_elapsed[it->second];
+		}
+
+		inline static size_t NumRunning() { return _targets.size(); }
+
+		// Moves every tween forward. Called by UpdateAll while any are running.
+		inline static void Advance(Uint64 dT)
+		{
+			const size_t n = _targets.size();
+			const float step = (float)dT;
+
+			_t.resize(n);
+
+			for (size_t i = 0; i < n; i++)
+			{
+				const float e = std::min(_elapsed[i] + step, _duration[i]);
+				_elapsed[i] = e;
+				_t[i] = _duration[i] > 0.f ? e / _duration[i] : 1.f;
+			}
+
+			for (size_t i = 0; i < n; i++)
+			{
+				if (_ease[i] != Ease::LINEAR) _t[i] = Eased(_ease[i], _t[i]);
+			}
+
+			for (int c = 0; c < 4; c++)
+			{
+				const float* from = _from[c].data();
+				const float* to = _to[c].data();
+				float* out = _out[c].data();
+
+				for (size_t i = 0; i < n; i++)
+				{
+					out[i] = from[i] + (to[i] - from[i]) * _t[i];
+				}
+			}
+
+			for (size_t i = 0; i < n; i++) _Write(i);
+
+			for (size_t i = n; i--;)
+			{
+				if (_elapsed[i] >= _duration[i]) _Erase(i);
+			}
+		}
+
+	private:
+		enum class Kind : uint8_t { POSITION, SIZE, COLOUR, FLOAT };
+
+		// Wakes for UpdateAll while tweens are running, so they cost one Update call in total.
+		struct Driver : IUpdateable
+		{
+			bool Update(Uint64 dT)
+			{
+				Advance(dT);
+				return !_targets.empty();
+			}
+		};
+
+		inline static std::vector<void*> _targets = {};
+		inline static std::vector<Kind> _kinds = {};
+		inline static std::vector<Ease> _ease = {};
+		inline static std::vector<float> _elapsed = {};
+		inline static std::vector<float> _duration = {};
+		inline static std::vector<float> _from[4] = {};
+		inline static std::vector<float> _to[4] = {};
+		inline static std::vector<float> _out[4] = {};
+		inline static std::vector<float> _t = {};
+		inline static std::vector<IContainer*> _layout_owners = {};
+		inline static std::vector<IRenderable*> _render_owners = {};
+		inline static std::unordered_map<const void*, size_t> _index = {};
+		inline static Driver _driver;
+
+		inline static void _Start(Kind kind, void* target, const float from[4], const float to[4], Uint64 duration, Ease ease, IContainer* layout_owner, IRenderable* render_owner)
+		{
+			LayoutLock lock;
+
+			auto it = _index.find(target);
+			size_t i;
+
+			if (it != _index.end())
+			{
+				i = it->second;
+			}
+			else
+			{
+				i = _targets.size();
+				_index.emplace(target, i);
+
+				_targets.push_back(target);
+				_kinds.push_back(kind);
+				_ease.push_back(ease);
+				_elapsed.push_back(0.f);
+				_duration.push_back(0.f);
+				_layout_owners.push_back(nullptr);
+				_render_owners.push_back(nullptr);
+
+				for (int c = 0; c < 4; c++)
+				{
+					_from[c].push_back(0.f);
+					_to[c].push_back(0.f);
+					_out[c].push_back(0.f);
+				}
+			}
+
+			_kinds[i] = kind;
+			_ease[i] = ease;
+			_elapsed[i] = 0.f;
+			_duration[i] = (float)duration;
+			_layout_owners[i] = layout_owner;
+			_render_owners[i] = render_owner;
+
+			for (int c = 0; c < 4; c++)
+			{
+				_from[c][i] = from[c];
+				_to[c][i] = to[c];
+			}
+
+			// Without a duration the target jumps straight to the end
+			if (duration == 0)
+			{
+				for (int c = 0; c < 4; c++) _out[c][i] = to[c];
+
+				_Write(i);
+				_Erase(i);
+				return;
+			}
+
+			_driver.Wake();
+		}
+
+		inline static void _Write(size_t i)
+		{
+			const float* o[4] = { &_out[0][i], &_out[1][i], &_out[2][i], &_out[3][i] };
+
+			switch (_kinds[i])
+			{
+			case Kind::POSITION:
+				*static_cast<GUIPosition*>(_targets[i]) = GUIPosition({ *o[0], *o[1] }, { *o[2], *o[3] });
+				break;
+			case Kind::SIZE:
+				*static_cast<GUISize*>(_targets[i]) = GUISize({ *o[0], *o[1] }, { *o[2], *o[3] });
+				break;
+			case Kind::COLOUR:
+			{
+				SDL::Colour& c = *static_cast<SDL::Colour*>(_targets[i]);
+				c.r = (Uint8)std::clamp(std::round(*o[0]), 0.f, 255.f);
+				c.g = (Uint8)std::clamp(std::round(*o[1]), 0.f, 255.f);
+				c.b = (Uint8)std::clamp(std::round(*o[2]), 0.f, 255.f);
+				c.a = (Uint8)std::clamp(std::round(*o[3]), 0.f, 255.f);
+				break;
+			}
+			case Kind::FLOAT:
+				*static_cast<float*>(_targets[i]) = *o[0];
+				break;
+			}
+
+			if (_layout_owners[i] != nullptr) _layout_owners[i]->InvalidateLayout();
+			if (_render_owners[i] != nullptr) _render_owners[i]->Invalidate();
+		}
+
+		// Moves the last tween into slot i.
+		inline static void _Erase(size_t i)
+		{
+			const size_t last = _targets.size() - 1;
+
+			_index.erase(_targets[i]);
+
+			if (i != last)
+			{
+				_index[_targets[last]] = i;
+
+				_targets[i] = _targets[last];
+				_kinds[i] = _kinds[last];
+				_ease[i] = _ease[last];
+				_elapsed[i] = _elapsed[last];
+				_duration[i] = _duration[last];
+				_layout_owners[i] = _layout_owners[last];
+				_render_owners[i] = _render_owners[last];
+
+				for (int c = 0; c < 4; c++)
+				{
+					_from[c][i] = _from[c][last];
+					_to[c][i] = _to[c][last];
+					_out[c][i] = _out[c][last];
+				}
+			}
+
+			_targets.pop_back();
+			_kinds.pop_back();
+			_ease.pop_back();
+			_elapsed.pop_back();
+			_duration.pop_back();
+			_layout_owners.pop_back();
+			_render_owners.pop_back();
+
+			for (int c = 0; c < 4; c++)
+			{
+				_from[c].pop_back();
+				_to[c].pop_back();
+				_out[c].pop_back();
+			}
+		}
+	};
+}
\ No newline at end of file
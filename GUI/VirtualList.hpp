@@ -0,0 +1,255 @@
+#pragma once
+#include "GUI.hpp"
+#include "Pointer.hpp"
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace GUI
+{
+	// A scrolling list of equally tall rows over any number of items. Row widgets exist only for the
+	// rows in view and a few past each edge; when the list scrolls, rows leaving that window are bound
+	// to the items coming into it instead of being destroyed. Memory and layout cost depend on the
+	// height of the list, not on the number of items. Rows wholly outside the list stay bound but
+	// hidden, so they neither draw nor take input. Rows partly outside only take input inside the list,
+	// but still draw past its edges; put the list in a CachedGroup of the same shape to clip them.
+	struct VirtualList : public IContainer
+	{
+		// Creates a row widget. Its shape is evaluated in a cell one row tall.
+		typedef std::function<std::shared_ptr<IContainer>()> RowFactory;
+		// Shows the item at index in a row widget, which may have shown any other item before.
+		typedef std::function<void(IContainer& row, size_t index)> RowBinder;
+
+		// Call InvalidateLayout after changing these directly.
+		float row_height;
+		// Rows bound past each edge of the view, so short scrolls bind nothing.
+		size_t overscan;
+
+		// Pixels scrolled per notch of the mouse wheel.
+		float wheel_step;
+
+		inline VirtualList(const GUIRect& shape, float row_height, size_t count, RowFactory create, RowBinder bind, size_t overscan = 2, int hit_order = 0)
+			: IContainer(shape), row_height(row_height), overscan(overscan), wheel_step(row_height * 3.f),
+			  _count(count), _create(create), _bind(bind), _hit_region(*this, hit_order) {}
+
+		inline ~VirtualList()
+		{
+			_Resize(0);
+		}
+
+		size_t NumChildren() const { return _rows.size(); }
+		size_t ChildPosition(std::shared_ptr<IContainer> child) const
+		{
+			const size_t slot = _GetSlot(*child);
+			return slot < _rows.size() && _rows[slot] == child ? slot : ~(size_t)0;
+		}
+
+		inline size_t GetCount() const { return _count; }
+
+		// Changes the number of items. Rows still showing an item keep it; call Rebind if items changed.
+		inline void SetCount(size_t count)
+		{
+			if (count == _count) return;
+
+			_count = count;
+			_scroll = std::min(_scroll, GetMaxScroll());
+			InvalidateLayout();
+		}
+
+		// Binds every row again on the next layout, after the items in view changed.
+		inline void Rebind()
+		{
+			std::fill(_indices.begin(), _indices.end(), npos);
+			InvalidateLayout();
+		}
+
+		// Binds the row showing an item again, if it has one.
+		inline void Rebind(size_t index)
+		{
+			IContainer* row = GetRow(index);
+			if (row != nullptr) _bind(*row, index);
+		}
+
+		// The row widget showing an item, or nullptr if the item has no row.
+		inline IContainer* GetRow(size_t index) const
+		{
+			if (_rows.empty()) return nullptr;
+
+			const size_t slot = index % _rows.size();
+			return _indices[slot] == index ? _rows[slot].get() : nullptr;
+		}
+
+		// Distance from the top of the first item to the top of the list.
+		// Kept in double precision, as a float cannot place rows millions of pixels down exactly.
+		inline double GetScroll() const { return _scroll; }
+		inline double GetMaxScroll() const { return std::max(0.0, (double)_count * row_height - _view.h); }
+
+		inline void SetScroll(double scroll)
+		{
+			scroll = std::clamp(scroll, 0.0, GetMaxScroll());
+			if (scroll == _scroll) return;
+
+			_scroll = scroll;
+			InvalidateLayout();
+		}
+
+		inline void ScrollBy(double delta) { SetScroll(_scroll + delta); }
+
+		// Scrolls as little as possible to show the whole of an item.
+		inline void ScrollTo(size_t index)
+		{
+			const double top = (double)index * row_height;
+
+			if (top < _scroll) SetScroll(top);
+			else if (top + row_height > _scroll + _view.h) SetScroll(top + row_height - _view.h);
+		}
+
+		// Scrolls with the mouse wheel. At either end the event bubbles on to the parent.
+		bool OnPointerEvent(const PointerEvent& e)
+		{
+			if (e.type != PointerEvent::Type::WHEEL) return false;
+
+			int notches = e.event.wheel.y;
+			if (e.event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED) notches = -notches;
+
+			const double before = _scroll;
+			ScrollBy(-(double)notches * wheel_step);
+
+			return _scroll != before;
+		}
+
+	protected:
+		static constexpr size_t npos = ~(size_t)0;
+
+		// Row widgets, where the item at index i is shown by the row in slot i % _rows.size().
+		std::vector<std::shared_ptr<IContainer>> _rows = {};
+		// The item each row shows, or npos.
+		std::vector<size_t> _indices = {};
+
+		size_t _count;
+		double _scroll = 0.0;
+		SDL::FRect _view = {};
+
+		RowFactory _create;
+		RowBinder _bind;
+		HitRegion _hit_region;
+
+		// Rows are made by the list itself.
+		bool _AddChild(std::shared_ptr<IContainer> child) { return false; }
+
+		// Removing a row drops every binding; the next layout makes the rows it is missing.
+		void _RemoveChild(size_t index)
+		{
+			assert(index < _rows.size());
+
+			_SetSlot(*_rows[index], ~(size_t)0);
+			_rows.erase(std::next(_rows.begin(), index));
+			for (size_t i = index; i < _rows.size(); i++) _SetSlot(*_rows[i], i);
+
+			_indices.assign(_rows.size(), npos);
+			InvalidateLayout();
+		}
+
+		void _ClearChildren()
+		{
+			for (auto& row : _rows)
+			{
+				row->parent = nullptr;
+				_SetSlot(*row, ~(size_t)0);
+			}
+
+			_rows.clear();
+			_indices.clear();
+			InvalidateLayout();
+		}
+
+		std::shared_ptr<IContainer> _GetChild(size_t index) const
+		{
+			assert(index < _rows.size());
+			return _rows[index];
+		}
+
+		IContainer* _ChildAt(size_t index) const
+		{
+			assert(index < _rows.size());
+			return _rows[index].get();
+		}
+
+		void _SetParentShape(const SDL::FRect& parent)
+		{
+			_view = shape.Get(parent);
+			_hit_region.Set(_view);
+
+			_scroll = std::clamp(_scroll, 0.0, GetMaxScroll());
+
+			if (row_height <= 0.f)
+			{
+				_Resize(0);
+				return;
+			}
+
+			// Enough rows to cover the view at any scroll offset, plus the overscan
+			const size_t in_view = (size_t)std::ceil(_view.h / row_height) + 1;
+			const size_t num = std::min(_count, in_view + 2 * overscan);
+
+			_Resize(num);
+
+			if (num == 0) return;
+
+			const size_t top = (size_t)(_scroll / row_height);
+			const size_t first = std::min(top - std::min(top, overscan), _count - num);
+
+			for (size_t i = first; i < first + num; i++)
+			{
+				const size_t slot = i % num;
+				IContainer& row = *_rows[slot];
+
+				if (_indices[slot] != i)
+				{
+					_indices[slot] = i;
+					_bind(row, i);
+				}
+
+				const float y = (float)((double)i * row_height - _scroll);
+				row.SetParentShape(SDL::FRect(_view.x, _view.y + y, _view.w, row_height));
+
+				// Applied again to hidden rows, in case binding gave them new children
+				const bool hidden = y + row_height <= 0.f || y >= _view.h;
+				if (hidden || row.IsHidden()) row.SetHidden(hidden);
+
+				// Likewise for rows crossing an edge, whose input is kept inside the list
+				if (!hidden && (y < 0.f || y + row_height > _view.h)) row.SetHitClip(_view);
+				else if (row.IsHitClipped()) row.ClearHitClip();
+			}
+		}
+
+		// Makes or destroys rows to have num. Bindings depend on the number of rows, so they are dropped if it changes.
+		void _Resize(size_t num)
+		{
+			if (num == _rows.size()) return;
+
+			while (_rows.size() > num)
+			{
+				std::shared_ptr<IContainer> row = _rows.back();
+				_rows.pop_back();
+
+				row->parent = nullptr;
+				_SetSlot(*row, ~(size_t)0);
+				DeleteTree(row.get());
+			}
+
+			while (_rows.size() < num)
+			{
+				std::shared_ptr<IContainer> row = _create();
+				assert(row != nullptr && row->parent == nullptr);
+
+				row->parent = this;
+				_SetSlot(*row, _rows.size());
+				_rows.push_back(row);
+			}
+
+			_indices.assign(num, npos);
+		}
+	};
+}
\ No newline at end of file
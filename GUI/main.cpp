@@ -5,7 +5,10 @@
 
 //#define DEBUG_GUI_RENDER
 //#define DEBUG_GUI_CONTAINERS
+//#define GUI_PROFILE
 #include "GUIElements.hpp"
+#include "Frame.hpp"
+#include "DebugDraw.hpp"
 
 void Program(int argc, char* argv[], SDL::Window& w, SDL::Renderer& r)
 {
@@ -22,57 +25,51 @@ void Program(int argc, char* argv[], SDL::Window& w, SDL::Renderer& r)
 		}
 	);
 
-	root.AddChild
+	root.Emplace<GUI::BorderedFilledRect>
 	(
-		std::shared_ptr<GUI::BorderedFilledRect>
-		(
-			new GUI::BorderedFilledRect
-			(
-				0,
-				r,
-				{
-					{ 0.f, 0.f }, {  35.f, 35.f },
-					{ 1.f, 0.f }, { -70.f, 20.f }
-				},
-				SDL::VERY_DARK_GREY,
-				SDL::LIGHT_GREY
-			)
-		)
+		0,
+		r,
+		GUI::GUIRect
+		{
+			{ 0.f, 0.f }, {  35.f, 35.f },
+			{ 1.f, 0.f }, { -70.f, 20.f }
+		},
+		SDL::VERY_DARK_GREY,
+		SDL::LIGHT_GREY
 	);
 
-	root.AddChild
+	root.Emplace<GUI::BorderedFilledRect>
 	(
-		std::shared_ptr<GUI::BorderedFilledRect>
-		(
-			new GUI::BorderedFilledRect
-			(
-				0,
-				r,
-				{
-					{ 0.f, 0.f }, { 35.f, 90.f },
-					{ 0.f, 0.f }, { 50.f, 20.f }
-				},
-				SDL::VERY_DARK_GREY,
-				SDL::LIGHT_GREY
-			)
-		)
+		0,
+		r,
+		GUI::GUIRect
+		{
+			{ 0.f, 0.f }, { 35.f, 90.f },
+			{ 0.f, 0.f }, { 50.f, 20.f }
+		},
+		SDL::VERY_DARK_GREY,
+		SDL::LIGHT_GREY
 	);
 
-	auto volume = new GUI::FloatSlider
+	auto volume = root.Emplace<GUI::FloatSlider>
 	(
 		r,
+		GUI::GUIRect
 		{
 			{ 0.f, 0.f }, {  35.f, 35.f },
 			{ 1.f, 0.f }, { -70.f, 20.f }
 		},
+		GUI::GUIPosition
 		{
 			{  0.f, 0.5f },
 			{ 10.f, 0.0f }
 		},
+		GUI::GUIPosition
 		{
 			{   1.f, 0.5f },
 			{ -10.f, 0.0f }
 		},
+		GUI::GUIRect
 		{
 			{ 0.f, 0.f }, { -9.f, -9.f },
 			{ 0.f, 0.f }, { 18.f, 18.f }
@@ -81,36 +78,35 @@ void Program(int argc, char* argv[], SDL::Window& w, SDL::Renderer& r)
 		Button::LEFT
 	);
 
-	volume->AddChild
+	volume->Emplace<GUI::FilledRect>
 	(
-		std::shared_ptr<GUI::FilledRect>
-		(
-			new GUI::FilledRect
-			(
-				0,
-				r,
-				{
-					{ 0.f, 0.f }, { -9.f, -9.f },
-					{ 0.f, 0.f }, { 18.f, 18.f }
-				},
-				SDL::GREY
-			)
-		)
+		0,
+		r,
+		GUI::GUIRect
+		{
+			{ 0.f, 0.f }, { -9.f, -9.f },
+			{ 0.f, 0.f }, { 18.f, 18.f }
+		},
+		SDL::GREY
 	);
 
-	auto toggle = new GUI::Toggle
+	auto toggle = root.Emplace<GUI::Toggle>
 	(
 		r,
+		GUI::GUIRect
 		{
 			{ 0.f, 0.f }, { 35.f, 90.f },
 			{ 0.f, 0.f }, { 50.f, 20.f }
 		},
+		GUI::GUIPosition
 		{
 			{ 0.f, 0.5f }, { 10.f,  0.f }
 		},
+		GUI::GUIPosition
 		{
 			{ 1.f, 0.5f }, { -10.f,  0.f }
 		},
+		GUI::GUIRect
 		{
 			{ 0.f, 0.f }, { 0.f, 0.f },
 			{ 1.f, 1.f }, { 0.f, 0.f }
@@ -120,24 +116,16 @@ void Program(int argc, char* argv[], SDL::Window& w, SDL::Renderer& r)
 		Button::LEFT
 	);
 
-	root.AddChild(std::shared_ptr<GUI::FloatSlider>(volume));
-	root.AddChild(std::shared_ptr<GUI::Toggle     >(toggle));
-
-	toggle->AddChild
+	toggle->Emplace<GUI::FilledRect>
 	(
-		std::shared_ptr<GUI::FilledRect>
-		(
-			new GUI::FilledRect
-			(
-				0,
-				r,
-				{
-					{ 0.f, 0.f }, { -9.f, -9.f },
-					{ 0.f, 0.f }, { 18.f, 18.f }
-				},
-				SDL::GREY
-			)
-		)
+		0,
+		r,
+		GUI::GUIRect
+		{
+			{ 0.f, 0.f }, { -9.f, -9.f },
+			{ 0.f, 0.f }, { 18.f, 18.f }
+		},
+		SDL::GREY
 	);
 
 	root.SetParentShape({ { 0.f, 0.f }, size });
@@ -151,45 +139,101 @@ void Program(int argc, char* argv[], SDL::Window& w, SDL::Renderer& r)
 		Input::GetTypedEventSubject(Event::Type::QUIT)
 	);
 
-	Listener<const Event&> resize_listener
+	Listener<const Event&> window_listener
 	(
-		[&size, &root](const Event& e)->void
+		[&size](const Event& e)->void
 		{
+			// The window contents were lost, so the whole frame is presented again
+			if (e.window.event == SDL_WINDOWEVENT_EXPOSED)
+			{
+				GUI::Damage::AddAll();
+				return;
+			}
+
 			if (e.window.event != SDL_WINDOWEVENT_RESIZED) return;
 
 			size.w = e.window.data1;
 			size.h = e.window.data2;
-
-			root.SetParentShape({ { 0.f, 0.f }, size });
 		},
 		Input::GetTypedEventSubject(Event::Type::WINDOWEVENT)
 	);
 
-	Uint64 t = GetTicks64();
-	Uint64 dT = 0;
+	// Only regions that changed since the last frame are redrawn.
+	GUI::RetainedFrame frame(r);
+
+	// Overlays are drawn over the frame, so it is presented every frame while one is shown.
+	frame.always_present = GUI::DebugDraw::layers != GUI::DebugDraw::NONE;
+
+	// F2 outlines the layout, F3 shows what each frame costs.
+	Listener<const Event&> debug_listener
+	(
+		[&frame](const Event& e)->void
+		{
+			if (e.key.repeat) return;
+
+			if (e.key.keysym.sym == SDLK_F2)
+			{
+				GUI::DebugDraw::layers = GUI::DebugDraw::layers == GUI::DebugDraw::NONE ? GUI::DebugDraw::ALL : GUI::DebugDraw::NONE;
+			}
+			else if (e.key.keysym.sym == SDLK_F3)
+			{
+				GUI::Stats::SetEnable(!GUI::Stats::IsEnabled());
+			}
+			else return;
+
+			frame.always_present = GUI::Stats::IsEnabled() || GUI::DebugDraw::layers != GUI::DebugDraw::NONE;
+		},
+		Input::GetTypedEventSubject(Event::Type::KEYDOWN)
+	);
 
 	do
 	{
-		dT = GetTicks64() - t;
-		t += dT;
+		// Sleeps until there is input, unless something is animating, needs redrawing or an overlay is shown.
+		const Uint64 dT = GUI::FrameScheduler::NextFrame(root, frame);
+
+		GUI_PROFILE_FRAME();
+		GUI::Stats::BeginFrame();
+
+		{
+			GUI_PROFILE_SCOPE("Input::Update");
+			Input::Update();
 
-		Input::Update();
+			// Mouse motion is merged into one event per frame
+			GUI::PointerRouter::Flush();
+		}
 
 		GUI::IUpdateable::UpdateAll(dT);
 
-		r.SetDrawColour(BLACK);
-		r.Clear();
+		// Only containers that were resized or invalidated are laid out again.
+		root.SetParentShape({ { 0.f, 0.f }, size });
+
+		// Elements outside the window are skipped when rendering.
+		GUI::IContainer::Cull(root, { { 0.f, 0.f }, size });
 
-		GUI::IRenderable::RenderAllGUI();
+		const bool redrawn = frame.Render();
+
+		GUI::Stats::EndFrame();
+
+		if (!redrawn) continue;
 
 #ifdef DEBUG_GUI_CONTAINERS
-		GUI::IContainer::RenderAllParents(r);
-		GUI::IContainer::RenderAllShapes(r);
-		GUI::IContainer::RenderAllAnchors(r);
+		GUI::DebugDraw::RenderAll(r, { { 0.f, 0.f }, size });
+#else
+		GUI::DebugDraw::Render(r, root, { { 0.f, 0.f }, size });
 #endif
 
-		r.Present();
+		if (GUI::Stats::IsEnabled()) GUI::Stats::DrawOverlay(r, { 8.f, 8.f });
+
+		{
+			GUI_PROFILE_SCOPE("Present");
+			r.Present();
+		}
 	} while (running);
+
+#ifdef GUI_PROFILE
+	// Open in chrome://tracing or ui.perfetto.dev
+	GUI::Profiler::WriteTrace("gui_trace.json");
+#endif
 }
 
 int main(int argc, char* argv[])
@@ -207,8 +251,11 @@ int main(int argc, char* argv[])
 		return -1;
 	}
 
+	GUI::PointerRouter::Init();
+
 	if (MIX::Init(MIX::InitFlags::MP3 | MIX::InitFlags::OGG) == MIX::InitFlags::NONE)
 	{
+		GUI::PointerRouter::Quit();
 		Input::Quit();
 		Quit();
 		return -1;
@@ -224,6 +271,7 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	GUI::PointerRouter::Quit();
 	Input::Quit();
 	MIX::Quit;
 	Quit();